@@ -17,13 +17,26 @@
 #define __HEIGHT 9
 #define __HEIGHT2 10
 
+/*
+ * test_tree:  the tree the helpers below (and t1..t16) build and
+ *   query.  bst<int>, or bst_int_set<int> when compiled with
+ *   -DBST_TEST_INT_SET (the int_set_tN executables, see makefile):
+ *   t1..t16 use only operations the two have in common.
+ */
+#ifdef BST_TEST_INT_SET
+#include "bst_int.h"
+typedef bst_int_set<int> test_tree;
+#else
+typedef bst<int> test_tree;
+#endif
+
 
 
-bst<int>  * bst_create() {
-  return new bst<int>();
+test_tree  * bst_create() {
+  return new test_tree();
 }
 
-void bst_free(bst<int> *t) {
+void bst_free(test_tree *t) {
   delete t;
 }
 
@@ -52,7 +65,7 @@ int max_sb_height(int n) {
   return 1 + max_sb_height(big);
 }
 
-int sb_height_ok(bst<int> *t) {
+int sb_height_ok(test_tree *t) {
   int height, max_h, n;
 
   n = t->size();
@@ -79,17 +92,17 @@ int sb_height_ok(bst<int> *t) {
  *
  *           -2, -1, 0, 1, 2
  */
-void seq_build(int n, int start, bst<int> *&pt) {
+void seq_build(int n, int start, test_tree *&pt) {
   int i, x;
-    pt = new bst<int>();
+    pt = new test_tree();
     for(i=1, x=start; i<=n; i++, x++)
         pt->insert(x);
 }
 
-void seq_build_descending(int n, int start, bst<int> *&pt) {
+void seq_build_descending(int n, int start, test_tree *&pt) {
   int i, x;
 
-    pt = new bst<int>();
+    pt = new test_tree();
     for(i=1, x=start; i<=n; i++, x--)
         pt->insert(x);
 }
@@ -103,7 +116,7 @@ void seq_build_descending(int n, int start, bst<int> *&pt) {
  *
  *       Always returns 1
  */
-void build_1_N(int n, bst<int> *&pt) {
+void build_1_N(int n, test_tree *&pt) {
   int i;
   
   seq_build(n, 1, pt);
@@ -118,7 +131,7 @@ void build_1_N(int n, bst<int> *&pt) {
  *
  *       Always returns 1
  */
-void build_N_1(int n, bst<int> *&pt) {
+void build_N_1(int n, test_tree *&pt) {
   int i;
   
   seq_build_descending(n, n, pt);
@@ -131,7 +144,7 @@ void build_N_1(int n, bst<int> *&pt) {
  *       (thus only useful for time trials).
  */
 int build_1_N_free(int n) {
-  bst<int> *t;
+  test_tree *t;
 
     build_1_N(n, t);
     delete t;
@@ -151,7 +164,7 @@ int build_1_N_free(int n) {
  *
  *       return:  number of successful removals.
  */
-int rem_range(bst<int> *t, int lo, int hi){
+int rem_range(test_tree *t, int lo, int hi){
   int x;
   int ndel = 0;
 
@@ -188,20 +201,20 @@ int rem_range(bst<int> *t, int lo, int hi){
  *    rem_last_third:  *lo stores the smallest value deleted.
  *    rem_middle_third:  *lo stores the smallest value deleted.
  */
-int rem_first_third(bst<int> *t, int n, int &hi) {
+int rem_first_third(test_tree *t, int n, int &hi) {
   int third;
 
   third = n/3;
   hi = third;
   return rem_range(t, 1, third);
 }
-int rem_last_third(bst<int> *t, int n, int *lo) {
+int rem_last_third(test_tree *t, int n, int *lo) {
 
   *lo = (2*n)/3;
   return rem_range(t, *lo, n);
 }
 
-int rem_middle_third(bst<int> *t, int n, int *lo, int *hi) {
+int rem_middle_third(test_tree *t, int n, int *lo, int *hi) {
 
   *lo = n/3;
   *hi = 2*(*lo);
@@ -220,8 +233,8 @@ int rem_middle_third(bst<int> *t, int n, int *lo, int *hi) {
  *
  *       returns resulting BST
  */
-bst<int>* build_balanced(int h) {
-  bst<int> *t = bst_create();
+test_tree* build_balanced(int h) {
+  test_tree *t = bst_create();
   int n, nleaves, i, level, start, delta, x;
 
   if(h==-1) return t;
@@ -246,8 +259,8 @@ bst<int>* build_balanced(int h) {
   return t;
 }
 
-bst<int> * build_balanced_rem_evens(int h) {
-  bst<int> *t = build_balanced(h);
+test_tree * build_balanced_rem_evens(int h) {
+  test_tree *t = build_balanced(h);
   int x;
   int n = two_to_x(h+1)-1;
 
@@ -277,7 +290,7 @@ bst<int> * build_balanced_rem_evens(int h) {
  *         has not been implemented.
  */
 int leq_testA(int h, int *ntests, int *npassed) {
-  bst<int> *t = build_balanced(h);
+  test_tree *t = build_balanced(h);
   int x;
   int n = two_to_x(h+1)-1;
 
@@ -326,7 +339,7 @@ int leq_testA(int h, int *ntests, int *npassed) {
  *       not implemented.
  */
 int leq_testB(int h, int *ntests, int *npassed) {
-  bst<int> * t = build_balanced_rem_evens(h);
+  test_tree * t = build_balanced_rem_evens(h);
   int x, n_odds, n_evens;
   int n = two_to_x(h+1)-1;
 
@@ -375,7 +388,7 @@ int leq_testB(int h, int *ntests, int *npassed) {
  *
  */
 int range_testA(int h) {
-  bst<int> *t = build_balanced(h);
+  test_tree *t = build_balanced(h);
   int x, passed, i;
   int n = two_to_x(h+1)-1;
 
@@ -413,7 +426,7 @@ int range_testB(int h) {
   if(n<20)
     return range_testA(h);
 
-  bst<int> *t = build_balanced(h);
+  test_tree *t = build_balanced(h);
 
   lo = n/5;
   hi = n-lo;
@@ -458,7 +471,7 @@ int range_testC(int h) {
   if(n<40)
     return range_testA(h);
 
-  bst<int> *t = build_balanced_rem_evens(h);
+  test_tree *t = build_balanced_rem_evens(h);
                             //   there are 2^h odd entries
                             //    (before and after removing evens)
 
@@ -0,0 +1,597 @@
+/**
+ * bench.cpp:  micro-benchmarks comparing bst policies on larger
+ *    trees than the test suite uses.  Not part of the auto-grader
+ *    (build with "make bench").
+ *
+ *    usage:  ./bench [workload] [n] [nops] [zipf-s]
+ *
+ *    workloads:
+ *
+ *      zipf    n distinct keys are inserted in random order, then
+ *              nops contains() calls are made with keys drawn from
+ *              a Zipf(s) distribution, s=0.99 unless given (the hot
+ *              keys are spread over the key space).  Default size-balanced policy
+ *              vs. splaying vs. the default policy with a lookup
+ *              cache (bst_lookup_cache, 4096 sets).
+ *
+ *      insert  n distinct keys are inserted in random order, each
+ *              insert timed on its own;  prints mean, median, p99,
+ *              p99.9 and max latency per balancing policy.  The
+ *              amortized policies show their occasional expensive
+ *              insert (subtree rebuild, long splay) in the tail.
+ *
+ *      ingest  n keys arriving nearly sorted (each key displaced by
+ *              a few positions at most) are inserted with insert()
+ *              and with finger_insert();  then 0..n-1 in order with
+ *              insert() and with append_max().
+ *
+ *      buffered
+ *              n distinct keys inserted in random order into a bst
+ *              and into a bst_buffered (default buffer), for the
+ *              default and AVL policies;  then nops random
+ *              contains() calls on each.
+ *
+ *      absent  the multiples of 10 below 10n inserted in random
+ *              order, then nops contains() calls for random keys
+ *              below 10n (90% absent, spread between the members);
+ *              default policy without and with a Bloom filter
+ *              (bst_bloom_filter, 10 and 16 bits per key).
+ *
+ *      prefetch
+ *              n distinct keys inserted in random order, then nops
+ *              contains() calls for random keys (half absent);
+ *              default and AVL policies without and with
+ *              bst_prefetch, and the default policy with a Bloom
+ *              filter without and with prefetching
+ *              (bst_prefetch_with).  Try n from 1M up to 100M
+ *              (about 3 GB).
+ *
+ *      dump    n distinct keys inserted in random order, then the
+ *              tree written to /dev/null:  "[ x ]" per element with
+ *              std::ostream << (as the printing functions used to),
+ *              then with dump() through a bst_writer, indented and
+ *              compact.
+ *
+ *      strings n random words (10-19 letters), then n URL-like
+ *              keys (one long common prefix), inserted in random
+ *              order, then nops contains() calls (half absent):
+ *              bst<std::string> vs. bst_string_set (arena-interned
+ *              keys, cached prefix compares), and the bytes of a
+ *              front-coded freeze().  The cached prefix decides most
+ *              comparisons of the words but none of the URLs.
+ *
+ *      intset  n distinct keys inserted in random order, then nops
+ *              contains(), num_leq() and get_ith() calls each:
+ *              bst<int> (size-balanced, AVL) vs. bst_int_set
+ *              (B+-tree, branchless node search).
+ *
+ *      build   n values in 0..n/2 in random order (most repeated)
+ *              made into a set:  sort + unique + from_sorted_vec,
+ *              then from_unsorted on 1, 2, 4, ... threads up to the
+ *              number of cores.
+ *
+ *      all     (default) every workload above.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bst.h"
+#include "bst_buffered.h"
+#include "bst_int.h"
+#include "bst_strings.h"
+
+typedef std::chrono::steady_clock bench_clock;
+
+static double ms_since(bench_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(
+      bench_clock::now() - start).count();
+}
+
+// keys 0..n-1 in random order
+static std::vector<int> shuffled_keys(int n, std::mt19937 &rng) {
+  std::vector<int> keys(n);
+  int i;
+
+  for(i=0; i<n; i++)
+    keys[i] = i;
+  std::shuffle(keys.begin(), keys.end(), rng);
+  return keys;
+}
+
+/*
+ * func: zipf_queries
+ * desc: nops keys drawn from a Zipf(s) distribution over n keys:
+ *       the key of popularity rank r (1..n) is chosen with
+ *       probability proportional to 1/r^s.  Ranks are mapped to
+ *       keys through a random permutation.
+ */
+static std::vector<int> zipf_queries(int n, int nops, double s,
+    std::mt19937 &rng) {
+  std::vector<double> cdf(n);
+  std::vector<int> by_rank = shuffled_keys(n, rng);
+  std::vector<int> q(nops);
+  std::uniform_real_distribution<double> u(0.0, 1.0);
+  double total = 0.0;
+  int i, r;
+
+  for(i=0; i<n; i++) {
+    total += 1.0 / pow(i+1, s);
+    cdf[i] = total;
+  }
+  for(i=0; i<nops; i++) {
+    r = std::lower_bound(cdf.begin(), cdf.end(), u(rng) * total) - cdf.begin();
+    q[i] = by_rank[r < n ? r : n-1];
+  }
+  return q;
+}
+
+template <typename Tree>
+static void zipf_run(const char *name, const std::vector<int> &keys,
+    const std::vector<int> &queries) {
+  bench_clock::time_point start;
+  double build_ms, query_ms;
+  size_t i;
+  int hits = 0;
+  Tree t;
+
+  start = bench_clock::now();
+  for(i=0; i<keys.size(); i++)
+    t.insert(keys[i]);
+  build_ms = ms_since(start);
+
+  start = bench_clock::now();
+  for(i=0; i<queries.size(); i++)
+    hits += t.contains(queries[i]);
+  query_ms = ms_since(start);
+
+  printf("  %-16s build %9.1f ms   contains %7.1f ns/op   (hits %d)\n",
+      name, build_ms, 1e6 * query_ms / queries.size(), hits);
+}
+
+static void bench_zipf(int n, int nops, double s) {
+  std::mt19937 rng(251);
+  std::vector<int> keys = shuffled_keys(n, rng);
+  std::vector<int> queries = zipf_queries(n, nops, s, rng);
+
+  printf("zipf:  n=%d  contains=%d  s=%.2f\n", n, nops, s);
+  zipf_run<bst<int> >("size-balanced", keys, queries);
+  zipf_run<bst<int, std::less<int>, false, bst_splay> >("splay", keys, queries);
+  zipf_run<bst<int, std::less<int>, false, bst_size_balanced,
+      bst_lookup_cache<4096> > >("cached", keys, queries);
+}
+
+// latency at fraction q of the sorted samples
+static double percentile(const std::vector<double> &sorted, double q) {
+  size_t i = (size_t)(q * (sorted.size() - 1));
+
+  return sorted[i];
+}
+
+template <typename Tree>
+static void insert_run(const char *name, const std::vector<int> &keys) {
+  std::vector<double> lat(keys.size());
+  bench_clock::time_point start;
+  double total = 0.0;
+  size_t i;
+  Tree t;
+
+  for(i=0; i<keys.size(); i++) {
+    start = bench_clock::now();
+    t.insert(keys[i]);
+    lat[i] = 1e6 * ms_since(start);
+    total += lat[i];
+  }
+  std::sort(lat.begin(), lat.end());
+
+  printf("  %-16s mean %6.0f  p50 %6.0f  p99 %7.0f  p99.9 %8.0f  max %10.0f ns"
+      "   (height %d)\n", name, total / lat.size(), percentile(lat, 0.5),
+      percentile(lat, 0.99), percentile(lat, 0.999), lat.back(), t.height());
+}
+
+static void bench_insert(int n) {
+  std::mt19937 rng(251);
+  std::vector<int> keys = shuffled_keys(n, rng);
+
+  printf("insert:  n=%d  (per-insert latency)\n", n);
+  insert_run<bst<int> >("size-balanced", keys);
+  insert_run<bst<int, std::less<int>, false, bst_splay> >("splay", keys);
+  insert_run<bst<int, std::less<int>, false, bst_treap> >("treap", keys);
+  insert_run<bst<int, std::less<int>, false, bst_avl> >("avl", keys);
+  insert_run<bst<int, std::less<int>, false, bst_weight_balanced> >(
+      "weight-balanced", keys);
+}
+
+// 0..n-1 with every key swapped with one at most 8 places on
+static std::vector<int> nearly_sorted_keys(int n, std::mt19937 &rng) {
+  std::vector<int> keys(n);
+  int i, j;
+
+  for(i=0; i<n; i++)
+    keys[i] = i;
+  for(i=0; i<n; i++) {
+    j = i + (int)(rng() % 9);
+    if(j < n)
+      std::swap(keys[i], keys[j]);
+  }
+  return keys;
+}
+
+template <typename Tree>
+static void ingest_run(const char *name, const std::vector<int> &keys) {
+  bench_clock::time_point start;
+  double plain_ms, finger_ms, sorted_ms, append_ms;
+  size_t i;
+
+  {
+    Tree t;
+    start = bench_clock::now();
+    for(i=0; i<keys.size(); i++)
+      t.insert(keys[i]);
+    plain_ms = ms_since(start);
+  }
+  {
+    Tree t;
+    start = bench_clock::now();
+    for(i=0; i<keys.size(); i++)
+      t.finger_insert(keys[i]);
+    finger_ms = ms_since(start);
+  }
+  {
+    Tree t;
+    start = bench_clock::now();
+    for(i=0; i<keys.size(); i++)
+      t.insert((int)i);
+    sorted_ms = ms_since(start);
+  }
+  {
+    Tree t;
+    start = bench_clock::now();
+    for(i=0; i<keys.size(); i++)
+      t.append_max((int)i);
+    append_ms = ms_since(start);
+  }
+  printf("  %-16s nearly sorted:  insert %7.1f  finger_insert %7.1f ns/op"
+      "   sorted:  insert %7.1f  append_max %7.1f ns/op\n", name,
+      1e6 * plain_ms / keys.size(), 1e6 * finger_ms / keys.size(),
+      1e6 * sorted_ms / keys.size(), 1e6 * append_ms / keys.size());
+}
+
+static void bench_ingest(int n) {
+  std::mt19937 rng(251);
+  std::vector<int> keys = nearly_sorted_keys(n, rng);
+
+  printf("ingest:  n=%d\n", n);
+  ingest_run<bst<int> >("size-balanced", keys);
+  ingest_run<bst<int, std::less<int>, false, bst_treap> >("treap", keys);
+  ingest_run<bst<int, std::less<int>, false, bst_avl> >("avl", keys);
+  ingest_run<bst<int, std::less<int>, false, bst_weight_balanced> >(
+      "weight-balanced", keys);
+}
+
+template <typename Tree>
+static void buffered_run(const char *name, const std::vector<int> &keys,
+    const std::vector<int> &queries) {
+  bench_clock::time_point start;
+  double build_ms, query_ms;
+  size_t i;
+  int hits = 0;
+  Tree t;
+
+  start = bench_clock::now();
+  for(i=0; i<keys.size(); i++)
+    t.insert(keys[i]);
+  build_ms = ms_since(start);
+
+  start = bench_clock::now();
+  for(i=0; i<queries.size(); i++)
+    hits += t.contains(queries[i]);
+  query_ms = ms_since(start);
+
+  printf("  %-22s insert %7.1f ns/op   contains %7.1f ns/op   (hits %d)\n",
+      name, 1e6 * build_ms / keys.size(), 1e6 * query_ms / queries.size(),
+      hits);
+}
+
+static void bench_buffered(int n, int nops) {
+  std::mt19937 rng(251);
+  std::vector<int> keys = shuffled_keys(n, rng);
+  std::vector<int> queries(nops);
+  int i;
+
+  for(i=0; i<nops; i++)
+    queries[i] = rng() % (2*n);
+  printf("buffered:  n=%d  contains=%d\n", n, nops);
+  buffered_run<bst<int> >("size-balanced", keys, queries);
+  buffered_run<bst_buffered<int> >("size-balanced buffered", keys, queries);
+  buffered_run<bst<int, std::less<int>, false, bst_avl> >("avl", keys,
+      queries);
+  buffered_run<bst_buffered<int, std::less<int>, bst_avl> >("avl buffered",
+      keys, queries);
+}
+
+static void bench_absent(int n, int nops) {
+  std::mt19937 rng(251);
+  std::vector<int> keys = shuffled_keys(n, rng);
+  std::vector<int> queries(nops);
+  int i;
+
+  for(i=0; i<n; i++)
+    keys[i] *= 10;
+  for(i=0; i<nops; i++)
+    queries[i] = rng() % (10LL*n);
+  printf("absent:  n=%d  contains=%d  (90%% absent)\n", n, nops);
+  buffered_run<bst<int> >("size-balanced", keys, queries);
+  buffered_run<bst<int, std::less<int>, false, bst_size_balanced,
+      bst_bloom_filter<10> > >("bloom 10 bits/key", keys, queries);
+  buffered_run<bst<int, std::less<int>, false, bst_size_balanced,
+      bst_bloom_filter<16> > >("bloom 16 bits/key", keys, queries);
+}
+
+static void bench_prefetch(int n, int nops) {
+  std::mt19937 rng(251);
+  std::vector<int> keys = shuffled_keys(n, rng);
+  std::vector<int> queries(nops);
+  int i;
+
+  for(i=0; i<nops; i++)
+    queries[i] = rng() % (2LL*n);
+  printf("prefetch:  n=%d  contains=%d\n", n, nops);
+  buffered_run<bst<int> >("size-balanced", keys, queries);
+  buffered_run<bst<int, std::less<int>, false, bst_size_balanced,
+      bst_prefetch> >("size-balanced prefetch", keys, queries);
+  buffered_run<bst<int, std::less<int>, false, bst_avl> >("avl", keys,
+      queries);
+  buffered_run<bst<int, std::less<int>, false, bst_avl, bst_prefetch> >(
+      "avl prefetch", keys, queries);
+  buffered_run<bst<int, std::less<int>, false, bst_size_balanced,
+      bst_bloom_filter<10> > >("bloom", keys, queries);
+  buffered_run<bst<int, std::less<int>, false, bst_size_balanced,
+      bst_prefetch_with<bst_bloom_filter<10> > > >("bloom prefetch", keys,
+      queries);
+}
+
+static void bench_dump(int n) {
+  std::mt19937 rng(251);
+  std::vector<int> keys = shuffled_keys(n, rng);
+  bench_clock::time_point start;
+  bst<int> t;
+  int i;
+
+  for(i=0; i<n; i++)
+    t.insert(keys[i]);
+  printf("dump:  n=%d\n", n);
+
+  {
+    std::ofstream os("/dev/null");
+    start = bench_clock::now();
+    t.visit_preorder([&](const int &x){
+        os << "[ " << x << " ]\n";
+        return true;
+      });
+    os.flush();
+    printf("  %-16s %7.1f ms\n", "ostream <<", ms_since(start));
+  }
+  {
+    FILE *f = fopen("/dev/null", "w");
+    start = bench_clock::now();
+    {
+      bst_writer w(f);
+      t.dump(w);
+    }
+    printf("  %-16s %7.1f ms\n", "dump indented", ms_since(start));
+    start = bench_clock::now();
+    {
+      bst_writer w(f);
+      t.dump(w, true);
+    }
+    printf("  %-16s %7.1f ms\n", "dump compact", ms_since(start));
+    fclose(f);
+  }
+}
+
+template <typename Tree>
+static void intset_run(const char *name, const std::vector<int> &keys,
+    const std::vector<int> &queries) {
+  bench_clock::time_point start;
+  double build_ms, contains_ms, leq_ms, ith_ms;
+  size_t i;
+  long long sum = 0;
+  int x = 0;
+  Tree t;
+
+  start = bench_clock::now();
+  for(i=0; i<keys.size(); i++)
+    t.insert(keys[i]);
+  build_ms = ms_since(start);
+
+  start = bench_clock::now();
+  for(i=0; i<queries.size(); i++)
+    sum += t.contains(queries[i]);
+  contains_ms = ms_since(start);
+  start = bench_clock::now();
+  for(i=0; i<queries.size(); i++)
+    sum += t.num_leq(queries[i]);
+  leq_ms = ms_since(start);
+  start = bench_clock::now();
+  for(i=0; i<queries.size(); i++){
+    t.get_ith(1 + queries[i] % keys.size(), x);
+    sum += x;
+  }
+  ith_ms = ms_since(start);
+
+  printf("  %-16s insert %6.1f  contains %6.1f  num_leq %6.1f  get_ith %6.1f"
+      " ns/op   (%lld)\n", name, 1e6 * build_ms / keys.size(),
+      1e6 * contains_ms / queries.size(), 1e6 * leq_ms / queries.size(),
+      1e6 * ith_ms / queries.size(), sum);
+}
+
+static void bench_intset(int n, int nops) {
+  std::mt19937 rng(251);
+  std::vector<int> keys = shuffled_keys(n, rng);
+  std::vector<int> queries(nops);
+  int i;
+
+  for(i=0; i<nops; i++)
+    queries[i] = rng() % (2LL*n);
+  printf("intset:  n=%d  queries=%d\n", n, nops);
+  intset_run<bst<int> >("size-balanced", keys, queries);
+  intset_run<bst<int, std::less<int>, false, bst_avl> >("avl", keys,
+      queries);
+  intset_run<bst_int_set<int> >("bst_int_set", keys, queries);
+}
+
+static void bench_build(int n) {
+  std::mt19937 rng(251);
+  std::vector<int> vals(n);
+  bench_clock::time_point start;
+  int i, th, cores = (int)std::thread::hardware_concurrency();
+
+  for(i=0; i<n; i++)
+    vals[i] = rng() % (n/2 + 1);
+  printf("build:  n=%d  (%d cores)\n", n, cores);
+  {
+    std::vector<int> a(vals);
+    start = bench_clock::now();
+    std::sort(a.begin(), a.end());
+    a.erase(std::unique(a.begin(), a.end()), a.end());
+    bst<int> *t = bst<int>::from_sorted_vec(a, (int)a.size());
+    printf("  %-24s %8.1f ms   (size %d)\n", "sort+from_sorted_vec",
+        ms_since(start), t->size());
+    delete t;
+  }
+  for(th=1; th==1 || th<=cores; th*=2){
+    std::vector<int> a(vals);
+    char name[48];
+
+    start = bench_clock::now();
+    bst<int> *t = bst<int>::from_unsorted(std::move(a), th);
+    snprintf(name, sizeof name, "from_unsorted %d thread%s", th,
+        th > 1 ? "s" : "");
+    printf("  %-24s %8.1f ms   (size %d)\n", name, ms_since(start),
+        t->size());
+    delete t;
+  }
+}
+
+template <typename Set>
+static void strings_run(const char *name, Set & t,
+    const std::vector<std::string> & keys,
+    const std::vector<std::string> & queries) {
+  bench_clock::time_point start;
+  double t_insert;
+  size_t i;
+  long long hits = 0;
+
+  start = bench_clock::now();
+  for(i=0; i<keys.size(); i++)
+    t.insert(keys[i]);
+  t_insert = ms_since(start);
+  start = bench_clock::now();
+  for(i=0; i<queries.size(); i++)
+    hits += t.contains(queries[i]);
+  printf("  %-16s insert %7.1f ms   contains %7.1f ms   (%lld hits)\n",
+      name, t_insert, ms_since(start), hits);
+}
+
+static void strings_both(const char *name,
+    const std::vector<std::string> & keys,
+    const std::vector<std::string> & queries) {
+  size_t i, chars = 0;
+
+  for(i=0; i<keys.size(); i++)
+    chars += keys[i].size();
+  printf("strings (%s):  n=%zu  contains=%zu  (%zu key bytes)\n", name,
+      keys.size(), queries.size(), chars);
+  {
+    bst<std::string> t;
+    strings_run("std::string", t, keys, queries);
+  }
+  {
+    bst_string_set<> t;
+    strings_run("bst_string_set", t, keys, queries);
+    printf("  %-16s arena %zu bytes, frozen %zu bytes\n", "",
+        t.strings().bytes_used(), t.freeze().memory_bytes());
+  }
+}
+
+static void bench_strings(int n, int nops) {
+  std::mt19937 rng(251);
+  std::vector<int> ids = shuffled_keys(n, rng);
+  std::vector<std::string> keys(n), queries(nops);
+  char buf[64];
+  int i, j, len;
+
+  // words:  a query is a member or a member with one more letter
+  for(i=0; i<n; i++){
+    len = 10 + rng() % 10;
+    for(j=0; j<len; j++)
+      keys[i] += (char)('a' + rng() % 26);
+  }
+  for(i=0; i<nops; i++){
+    queries[i] = keys[rng() % n];
+    if(rng() % 2)
+      queries[i] += 'x';
+  }
+  strings_both("words", keys, queries);
+
+  // URLs:  the even ids are members
+  for(i=0; i<n; i++){
+    sprintf(buf, "https://www.example.com/catalog/item/%09d", 2*ids[i]);
+    keys[i] = buf;
+  }
+  for(i=0; i<nops; i++){
+    sprintf(buf, "https://www.example.com/catalog/item/%09d",
+        (int)(rng() % (2LL*n)));
+    queries[i] = buf;
+  }
+  strings_both("urls", keys, queries);
+}
+
+int main(int argc, char *argv[]) {
+  const char *workload = "all";
+  int n = 1000000;
+  int nops = 5000000;
+  double zipf_s = 0.99;
+  bool all;
+
+  if(argc > 1)
+    workload = argv[1];
+  if(argc > 2)
+    n = atoi(argv[2]);
+  if(argc > 3)
+    nops = atoi(argv[3]);
+  if(argc > 4)
+    zipf_s = atof(argv[4]);
+
+  all = strcmp(workload, "all") == 0;
+  if(all || strcmp(workload, "zipf") == 0)
+    bench_zipf(n, nops, zipf_s);
+  if(all || strcmp(workload, "insert") == 0)
+    bench_insert(n);
+  if(all || strcmp(workload, "ingest") == 0)
+    bench_ingest(n);
+  if(all || strcmp(workload, "buffered") == 0)
+    bench_buffered(n, nops);
+  if(all || strcmp(workload, "absent") == 0)
+    bench_absent(n, nops);
+  if(all || strcmp(workload, "prefetch") == 0)
+    bench_prefetch(n, nops);
+  if(all || strcmp(workload, "dump") == 0)
+    bench_dump(n);
+  if(all || strcmp(workload, "intset") == 0)
+    bench_intset(n, nops);
+  if(all || strcmp(workload, "build") == 0)
+    bench_build(n);
+  if(all || strcmp(workload, "strings") == 0)
+    bench_strings(n, nops);
+
+  return 0;
+}
@@ -1,48 +1,1221 @@
 #ifndef _BST_H
 #define _BST_H
 
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cmath>
+#include <functional>
 #include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
-template <typename T>
+/*
+ * BST_METRICS:  define it (e.g. -DBST_METRICS) to have every bst
+ * count what its operations cost (see bst_metrics and
+ * bst::metrics()).  Without it the probes below expand to nothing
+ * and a tree holds no counters.
+ */
+#ifdef BST_METRICS
+#define BST_PROBE_OP(o)   (metrics_op = bst_metrics::o, metrics_count.ops[metrics_op].calls++)
+#define BST_PROBE_AS(o)   (metrics_op = bst_metrics::o)
+#define BST_PROBE(f)      (metrics_count.ops[metrics_op].f++)
+#define BST_PROBE_N(f, n) (metrics_count.ops[metrics_op].f += (n))
+#else
+#define BST_PROBE_OP(o)   ((void)0)
+#define BST_PROBE_AS(o)   ((void)0)
+#define BST_PROBE(f)      ((void)0)
+#define BST_PROBE_N(f, n) ((void)0)
+#endif
+
+/**
+ * bst_compare<T, Compare>
+ *
+ * three-way comparison used by bst:  compare(c, a, b) returns a
+ * negative value, zero or a positive value as a is ordered before,
+ * equivalent to or after b under the (strict weak) ordering c.
+ *
+ * The generic version needs a second call to c only when a is not
+ * before b.  Key types with a native three-way comparison specialize
+ * it so that every level of a descent costs exactly one comparison.
+ */
+template <typename T, typename Compare>
+struct bst_compare {
+  static int compare(const Compare & c, const T & a, const T & b){
+    if(c(a, b)) return -1;
+    if(c(b, a)) return 1;
+    return 0;
+  }
+};
+
+// std::string under the default ordering:  one pass over the
+//   characters via std::string::compare.
+template <>
+struct bst_compare<std::string, std::less<std::string> > {
+  static int compare(const std::less<std::string> &,
+      const std::string & a, const std::string & b){
+    return a.compare(b);
+  }
+};
+
+/**
+ * Balancing policies for bst (the Balance template parameter).
+ *
+ * Each policy names the extra bookkeeping it needs in every node
+ * (node_base, empty if none);  the algorithms themselves live in bst
+ * and are selected by tag dispatch on the policy type.
+ *
+ *   bst_unbalanced      plain BST:  nodes stay where they are inserted.
+ *
+ *   bst_size_balanced   (default) a node is size-balanced when neither
+ *                       of its subtrees has more than 2k+1 nodes, k
+ *                       being the node count of the other one.  Any
+ *                       node found out of balance on the way back up
+ *                       from an insert/remove has its subtree rebuilt
+ *                       perfectly balanced, so the height never
+ *                       exceeds max_sb_height(n).  Amortized O(log n).
+ *
+ *   bst_splay           self-adjusting:  contains/insert/remove splay
+ *                       the accessed node to the root (top-down, no
+ *                       recursion).  Amortized O(log n) per operation,
+ *                       and a recently used key is found within a few
+ *                       hops, which suits skewed access patterns.
+ *                       get_ith, num_leq, num_geq and num_range splay
+ *                       too (select_range and quantiles do not).
+ *
+ *   bst_treap           randomized:  every node gets a random priority
+ *                       and the tree is kept heap-ordered on them by
+ *                       rotations (insert rotates the new node up,
+ *                       remove merges the children of the removed
+ *                       node).  Expected O(log n) per operation with
+ *                       O(1) expected rotations -- no subtree is ever
+ *                       rebuilt, so no operation is much slower than
+ *                       the others.
+ *
+ *   bst_avl             strictly balanced:  the heights of the two
+ *                       subtrees of every node differ by at most one,
+ *                       restored by single/double rotations on the way
+ *                       back up from an insert/remove.  Height is below
+ *                       1.44 lg(n+2), so every operation is WORST-CASE
+ *                       O(log n);  an insert does at most one (double)
+ *                       rotation, a remove O(1) amortized.
+ *
+ *   bst_weight_balanced BB[alpha] tree kept by rotations:  with w(t)
+ *                       = nodes in t + 1, neither child of a node
+ *                       may weigh more than 3 times the other.  A
+ *                       single or double rotation on each node of the
+ *                       update path restores the rule (parameters
+ *                       <3,2> of Hirai & Yamamoto), so an update is
+ *                       worst-case O(log n) and never rebuilds a
+ *                       subtree.  Height is below log_{4/3}(n+1),
+ *                       a looser bound than the 2k+1 rule of
+ *                       bst_size_balanced, which rotations alone
+ *                       cannot maintain.
+ */
+struct bst_unbalanced {
+  struct node_base { };
+};
+
+struct bst_size_balanced {
+  struct node_base {
+    int nodes;   // number of NODES in subtree (size counts copies)
+  };
+};
+
+struct bst_splay {
+  struct node_base { };
+};
+
+struct bst_weight_balanced {
+  struct node_base {
+    int nodes;   // number of NODES in subtree (size counts copies)
+  };
+};
+
+struct bst_avl {
+  struct node_base {
+    int ht;   // height of subtree (a leaf has ht 1)
+  };
+};
+
+struct bst_treap {
+  struct node_base {
+    unsigned prio;   // heap-ordered:  no child has a higher prio
+  };
+
+  // per-thread xorshift generator for node priorities
+  static unsigned next_priority(){
+    static thread_local unsigned state = 2463534242u;
+
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+  }
+};
+
+/**
+ * Lookup policies for bst (the Lookup template parameter):  what
+ * contains() consults before searching the tree.
+ *
+ * Each policy names the state a tree keeps for it (table, empty if
+ * none);  the algorithms live in bst (tag dispatch on the policy).
+ *
+ *   bst_no_lookup       (default) every contains() searches the tree.
+ *
+ *   bst_lookup_cache<S> 2-way set-associative cache of S sets holding
+ *                       recent contains() results, positive AND
+ *                       negative, indexed by std::hash<T>.  Entries
+ *                       are stamped with the tree's (64-bit)
+ *                       version, which every update bumps, so one
+ *                       increment invalidates the whole cache.  The victim in a
+ *                       set is the way not used last.  Hits and
+ *                       misses are counted (lookup_hits/misses).
+ *
+ *   bst_bloom_filter<B, H>
+ *                       blocked Bloom filter over the elements:  a
+ *                       contains(x) the filter rules out returns
+ *                       false without touching a node (a "hit");
+ *                       the others search the tree.  B bits per
+ *                       element (the memory budget) sets the false
+ *                       positive rate:  about 2% at B=8, 1% at
+ *                       B=10, 0.1% at B=16.  Each element sets its
+ *                       probe bits within one 512-bit block, so a
+ *                       test costs one cache miss.
+ *
+ *                       insert adds to the filter;  a Bloom filter
+ *                       cannot delete, so a remove only counts a
+ *                       stale entry.  The filter is rebuilt from the
+ *                       tree (O(n)), sized for twice the current
+ *                       size, by the first contains() after it
+ *                       filled up or after stale entries reached a
+ *                       quarter of its capacity:  O(1) amortized per
+ *                       update, and at most 2B bits per element.
+ *
+ *                       H hashes the elements (std::hash<T> by
+ *                       default).  Elements equivalent under the
+ *                       tree's Compare must hash alike, or the filter
+ *                       rules out elements that are present;  the
+ *                       default is therefore only accepted with
+ *                       std::less<T> or std::greater<T>.
+ *
+ *   bst_prefetch_with<L>
+ *                       L (any of the above) plus prefetching:  the
+ *                       descents of contains() and insert() prefetch
+ *                       both children of each node before comparing
+ *                       x with it, so the load of the next node
+ *                       overlaps the work at this one.  Helps trees
+ *                       much larger than the cache (not splay, whose
+ *                       contains() splays).  The state and hooks are
+ *                       those of L, e.g. with a Bloom filter the
+ *                       searches the filter lets through prefetch.
+ *
+ *   bst_prefetch        bst_prefetch_with<bst_no_lookup>.
+ */
+struct bst_no_lookup {
+  template <typename K>
+  struct table { };
+};
+
+template <typename L>
+struct bst_prefetch_with {
+  template <typename K>
+  struct table : L::template table<K> { };
+};
+
+typedef bst_prefetch_with<bst_no_lookup> bst_prefetch;
+
+/**
+ * bst_lookup_traits<Lookup>:  base is the policy whose hooks and
+ *   table a bst uses (Lookup itself, or L of bst_prefetch_with<L>);
+ *   prefetch tells whether its descents prefetch.
+ */
+template <typename L>
+struct bst_lookup_traits {
+  typedef L base;
+  static const bool prefetch = false;
+};
+
+template <typename L>
+struct bst_lookup_traits<bst_prefetch_with<L> > {
+  typedef L base;
+  static const bool prefetch = true;
+};
+
+/**
+ * bst_cache_key<K>
+ *
+ * how bst_lookup_cache keeps the key of an entry:  type is what an
+ * entry stores, store() fills it from a key and key() gives the key
+ * back.  By default a copy of K.  A key type that only refers to
+ * characters stored elsewhere (bst_istring) specializes it so that
+ * the cache owns a copy:  a looked-up key may be a temporary.
+ */
+template <typename K>
+struct bst_cache_key {
+  typedef K type;
+
+  static void store(type & slot, const K & x){
+    slot = x;
+  }
+
+  static const K & key(const type & slot){
+    return slot;
+  }
+};
+
+template <int Sets = 256>
+struct bst_lookup_cache {
+  static const int SETS = Sets;
+
+  template <typename K>
+  struct table {
+    struct entry {
+      typename bst_cache_key<K>::type key;
+      unsigned long long version;   // valid iff equal to table::version
+      bool               found;     // result of contains(key)
+    };
+
+    std::vector<entry>         slots;     // 2 ways per set
+    std::vector<unsigned char> last;      // way used last, per set
+    unsigned long long         version;   // 64 bits:  never wraps
+    unsigned long              hits;
+    unsigned long              misses;
+
+    table() : slots(2*Sets), last(Sets), version(1), hits(0), misses(0)
+    {
+      for(size_t i=0; i<slots.size(); i++)
+        slots[i].version = 0;
+    }
+  };
+};
+
+template <int BitsPerKey = 10, typename Hash = void>
+struct bst_bloom_filter {
+  static const int BLOCK_WORDS = 8;   // 512 bits:  one cache line
+  // probes per element:  ~ BitsPerKey * ln 2 is optimal
+  static const int PROBES = BitsPerKey * 69 / 100 < 1 ? 1 :
+                            BitsPerKey * 69 / 100 > 16 ? 16 :
+                            BitsPerKey * 69 / 100;
+
+  // the hash of a K:  Hash, or std::hash<K> if none was given
+  template <typename K>
+  struct hasher {
+    typedef typename std::conditional<std::is_void<Hash>::value,
+        std::hash<K>, Hash>::type type;
+  };
+
+  // spreads the bits of a std::hash value (ints hash to themselves)
+  static unsigned long long mix(unsigned long long h){
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+  }
+
+  template <typename K>
+  struct table {
+    std::vector<unsigned long long> bits;
+    size_t        blocks;
+    int           capacity;   // elements the filter is sized for
+    int           keys;       // elements added since the rebuild
+    int           stale;      // removals since the rebuild
+    bool          dirty;      // rebuild before the next use
+    unsigned long hits;
+    unsigned long misses;
+
+    table() : blocks(0), capacity(0), keys(0), stale(0), dirty(true),
+              hits(0), misses(0)
+    { }
+
+    // empties the filter and sizes it for twice n elements
+    void reset(int n){
+      capacity = 2 * (n < 64 ? 64 : n);
+      blocks = ((size_t)capacity * BitsPerKey + 511) / 512;
+      bits.assign(blocks * BLOCK_WORDS, 0);
+      keys = stale = 0;
+      dirty = false;
+    }
+
+    // probe i of hash h is bit (a + i*b) mod 512 of block h2 mod blocks
+    void add(size_t hash){
+      unsigned long long h = mix(hash);
+      unsigned long long *w = &bits[mix(h) % blocks * BLOCK_WORDS];
+      unsigned a = (unsigned)h, b = (unsigned)(h >> 32) | 1;
+      int i;
+
+      for(i=0; i<PROBES; i++, a += b)
+        w[(a >> 6) & 7] |= 1ULL << (a & 63);
+      keys++;
+    }
+
+    bool may_contain(size_t hash) const {
+      unsigned long long h = mix(hash);
+      const unsigned long long *w = &bits[mix(h) % blocks * BLOCK_WORDS];
+      unsigned a = (unsigned)h, b = (unsigned)(h >> 32) | 1;
+      int i;
+
+      for(i=0; i<PROBES; i++, a += b){
+        if((w[(a >> 6) & 7] & (1ULL << (a & 63))) == 0)
+          return false;
+      }
+      return true;
+    }
+  };
+};
+
+/**
+ * bst_lookup_ok<T, Compare, Lookup>:  false for a Bloom filter with
+ *   the default hash under a Compare whose equivalence may be coarser
+ *   than equality (see bst_bloom_filter).
+ */
+template <typename T, typename Compare, typename Lookup>
+struct bst_lookup_ok : std::true_type { };
+
+template <typename T, typename Compare, int B>
+struct bst_lookup_ok<T, Compare, bst_bloom_filter<B, void> >
+  : std::integral_constant<bool,
+        std::is_same<Compare, std::less<T> >::value ||
+        std::is_same<Compare, std::greater<T> >::value> { };
+
+/**
+ * struct bst_metrics
+ *
+ * Snapshot of the work done by one bst, by kind of operation
+ * (bst::metrics();  all zero unless compiled with BST_METRICS):
+ *
+ *   INSERT   insert, finger_insert, append_max, insert_sorted
+ *   REMOVE   remove, remove_sorted, compact
+ *   LOOKUP   contains, count
+ *   QUERY    get_ith, num_leq, num_geq, num_range, select_range,
+ *            quantiles, min, max
+ *   OTHER    everything else (copies, set operations, ...)
+ *
+ * The counters of an operation include the work of the operations
+ * it is built from (an insert that triggers a rebuild is charged
+ * the rebuild).
+ */
+struct bst_metrics {
+  enum op { INSERT, REMOVE, LOOKUP, QUERY, OTHER, N_OPS };
+
+  struct op_counts {
+    unsigned long long calls;
+    unsigned long long comparisons;    // key comparisons
+    unsigned long long visits;         // nodes examined by searches
+    unsigned long long allocs;         // nodes allocated
+    unsigned long long frees;          // nodes freed
+    unsigned long long rotations;      // (splay:  zig-zig steps)
+    unsigned long long rebuilds;       // subtrees rebuilt balanced
+    unsigned long long rebuilt_nodes;  // total size of those
+  };
+
+  op_counts ops[N_OPS];
+
+  bst_metrics() : ops() { }
+
+  static const char * name(int o){
+    static const char * const names[N_OPS] =
+      { "insert", "remove", "lookup", "query", "other" };
+
+    return names[o];
+  }
+
+  // sums over all kinds of operations
+  op_counts total() const {
+    op_counts t = op_counts();
+    int o;
+
+    for(o=0; o<N_OPS; o++){
+      t.calls         += ops[o].calls;
+      t.comparisons   += ops[o].comparisons;
+      t.visits        += ops[o].visits;
+      t.allocs        += ops[o].allocs;
+      t.frees         += ops[o].frees;
+      t.rotations     += ops[o].rotations;
+      t.rebuilds      += ops[o].rebuilds;
+      t.rebuilt_nodes += ops[o].rebuilt_nodes;
+    }
+    return t;
+  }
+};
+
+/**
+ * struct bst_memory
+ *
+ * Memory held by one bst (bst::memory_usage()).  Nodes live in
+ * slots of blocks ("slabs") owned by the tree, so a node costs
+ * exactly node_bytes -- sizeof the node, padding included;  the
+ * allocator's own overhead is paid once per block, not per node.
+ */
+struct bst_memory {
+  size_t nodes;            // nodes in the tree (tombstones included)
+  size_t dead_nodes;       // ... of which tombstones (lazy removal)
+  size_t node_bytes;       // bytes per slot
+  size_t blocks;           // blocks obtained from operator new
+  size_t reserved_bytes;   // all blocks:  slots plus block headers
+  size_t used_bytes;       // nodes * node_bytes
+  size_t free_slots;       // freed slots waiting to be reused
+  size_t unused_slots;     // never used slots of the newest block
+  size_t other_bytes;      // the bst object, finger and lookup table
+  double fragmentation;    // free_slots / (nodes + free_slots)
+};
+
+/**
+ * bst_is_char<V>:  true for the character types, which operator<<
+ *   prints as characters (or, for the wide ones, by its own rules)
+ *   rather than as the integers they are.
+ */
+template <typename V> struct bst_is_char : std::false_type { };
+template <> struct bst_is_char<char> : std::true_type { };
+template <> struct bst_is_char<signed char> : std::true_type { };
+template <> struct bst_is_char<unsigned char> : std::true_type { };
+template <> struct bst_is_char<wchar_t> : std::true_type { };
+template <> struct bst_is_char<char16_t> : std::true_type { };
+template <> struct bst_is_char<char32_t> : std::true_type { };
+
+/**
+ * class bst_writer
+ *
+ * Buffered text output for tree dumps (bst::dump and the printing
+ * functions):  text is formatted into one reusable buffer and
+ * written out in large chunks to a std::ostream, a FILE * or a file
+ * descriptor.  Integer values are converted by hand;  other types
+ * -- character types included -- go through operator<< (char,
+ * std::string and C strings are copied).
+ * The buffer is flushed when full, by flush() and on destruction.
+ */
+class bst_writer {
+
+  public:
+    static const size_t DEFAULT_CAPACITY = 1 << 16;
+
+    explicit bst_writer(std::ostream & os,
+        size_t capacity = DEFAULT_CAPACITY)
+      : os(&os), file(nullptr), fd(-1), buf(capacity < 64 ? 64 : capacity),
+        len(0)
+    { }
+
+    explicit bst_writer(FILE *f, size_t capacity = DEFAULT_CAPACITY)
+      : os(nullptr), file(f), fd(-1), buf(capacity < 64 ? 64 : capacity),
+        len(0)
+    { }
+
+    explicit bst_writer(int fd, size_t capacity = DEFAULT_CAPACITY)
+      : os(nullptr), file(nullptr), fd(fd),
+        buf(capacity < 64 ? 64 : capacity), len(0)
+    { }
+
+    bst_writer(const bst_writer &) = delete;
+    bst_writer & operator=(const bst_writer &) = delete;
+
+    ~bst_writer() {
+      flush();
+    }
+
+    void put(char c){
+      if(len == buf.size())
+        flush();
+      buf[len++] = c;
+    }
+
+    void put(const char *s, size_t n){
+      if(n > buf.size() - len){
+        flush();
+        if(n >= buf.size()){
+          _write(s, n);
+          return;
+        }
+      }
+      memcpy(&buf[len], s, n);
+      len += n;
+    }
+
+    void put(const char *s){
+      put(s, strlen(s));
+    }
+
+    void put(const std::string & s){
+      put(s.data(), s.size());
+    }
+
+    // n copies of c
+    void fill(char c, size_t n){
+      size_t k;
+
+      while(n > 0){
+        if(len == buf.size())
+          flush();
+        k = std::min(n, buf.size() - len);
+        memset(&buf[len], c, k);
+        len += k;
+        n -= k;
+      }
+    }
+
+    template <typename V>
+    void put_value(const V & v){
+      _put_value(v, std::integral_constant<bool,
+          std::is_integral<V>::value && !bst_is_char<V>::value>());
+    }
+
+    void put_value(char c){
+      put(c);
+    }
+
+    void put_value(const std::string & s){
+      put(s);
+    }
+
+    void put_value(const char *s){
+      put(s);
+    }
+
+    void flush(){
+      _write(buf.data(), len);
+      len = 0;
+    }
+
+  private:
+    template <typename V>
+    void _put_value(const V & v, std::true_type){
+      char d[24];
+      int i = sizeof d;
+      bool neg = v < V(0);
+      unsigned long long u = neg ? 0ULL - (unsigned long long)v
+                                 : (unsigned long long)v;
+
+      do {
+        d[--i] = (char)('0' + u % 10);
+        u /= 10;
+      } while(u != 0);
+      if(neg)
+        d[--i] = '-';
+      put(d + i, sizeof d - i);
+    }
+
+    template <typename V>
+    void _put_value(const V & v, std::false_type){
+      fmt.str("");
+      fmt.clear();
+      fmt << v;
+      put(fmt.str());
+    }
+
+    void _write(const char *s, size_t n){
+      ssize_t k;
+
+      if(n == 0)
+        return;
+      if(os != nullptr)
+        os->write(s, n);
+      else if(file != nullptr)
+        fwrite(s, 1, n, file);
+      else {
+        while(n > 0 && (k = ::write(fd, s, n)) > 0){
+          s += k;
+          n -= k;
+        }
+      }
+    }
+
+    std::ostream       *os;     // exactly one sink is set
+    FILE               *file;
+    int                 fd;
+    std::vector<char>   buf;
+    size_t              len;    // bytes used in buf
+    std::ostringstream  fmt;    // for values without a fast path
+};
+
+/**
+ * class bst<T, Compare, Multi, Balance, Lookup>
+ *
+ * General description:  binary search tree in which every node is
+ *    augmented with the number of elements stored in its subtree
+ *    (size); this is what makes the rank queries (get_ith, num_leq,
+ *    num_geq, num_range) O(h).
+ *
+ *    By default a bst stores a SET.  When Multi is true the tree is a
+ *    MULTISET:  each distinct value occupies a single node whose
+ *    count field records its multiplicity.  insert() bumps the count,
+ *    remove() decrements it and all size/rank queries count every
+ *    copy.  (see also the bst_multiset alias below the class.)
+ *
+ *    Values are ordered by Compare (std::less<T> by default).  Each
+ *    level of a search costs a single three-way comparison (see
+ *    bst_compare above).
+ *
+ *    The shape of the tree is maintained according to Balance (see
+ *    the balancing policies above), and contains() may be served
+ *    from a cache or a filter according to Lookup (see the lookup
+ *    policies).
+ *
+ *    Removal is eager by default;  see set_lazy_remove for marking
+ *    nodes dead (count 0) instead and compacting later.
+ */
+template <typename T, typename Compare = std::less<T>, bool Multi = false,
+          typename Balance = bst_size_balanced,
+          typename Lookup = bst_no_lookup>
 class bst {
 
+  // the lookup policy proper, and whether the descents prefetch
+  typedef typename bst_lookup_traits<Lookup>::base lookup_policy;
+  typedef std::integral_constant<bool,
+      bst_lookup_traits<Lookup>::prefetch> prefetch_tag;
+
+  static_assert(bst_lookup_ok<T, Compare, lookup_policy>::value,
+      "bst:  bst_bloom_filter needs a Hash consistent with Compare");
+
   private:
-    struct bst_node {
+    struct bst_node : Balance::node_base {
       T      val;
       bst_node *left;
       bst_node *right;
+      int    size;    // number of elements in subtree (copies included)
+      int    count;   // multiplicity of val (always 1 for a set;
+                      //   0 for a dead node, see set_lazy_remove)
 
       bst_node ( const T & _val = T{}, bst_node * l = nullptr, bst_node *r = nullptr)
-        : val { _val },  left { l }, right {r}
+        : val { _val },  left { l }, right {r}, size {1}, count {1}
       { }
     };
 
 
 
+    /*
+     * Node storage:  nodes are carved out of blocks owned by the
+     *   tree rather than allocated one at a time.  A removed node's
+     *   slot goes on a free list and is reused by the next insertion;
+     *   blocks are only released when the tree itself goes away.
+     */
+    struct node_block {
+      node_block *next;
+      bst_node   *slots;
+      int        capacity;
+    };
+
+    struct free_slot {
+      free_slot *next;
+    };
+
+    static const int MIN_BLOCK = 16;
+    static const int MAX_BLOCK = 1 << 16;
+
   public:
     // constructor:  initializes an empty tree
     bst(){
       root = nullptr;
+      max_dead = 0;
+      _init_pool();
+    }
+
+    // constructor:  empty tree ordered by the given comparator
+    explicit bst(const Compare & c) : cmp(c) {
+      root = nullptr;
+      max_dead = 0;
+      _init_pool();
+    }
+
+    // copy constructor:  O(n) deep copy preserving the shape of
+    //   other;  all nodes come from a single block.
+    bst(const bst & other) : cmp(other.cmp) {
+      root = nullptr;
+      max_dead = other.max_dead;
+      _init_pool();
+      if(other.root != nullptr){
+        _add_block(other.n_live);
+        root = _copy_nodes(other.root);
+        n_dead = other.n_dead;
+      }
+    }
+
+    // move constructor:  O(1) -- steals other's nodes, leaving it
+    //   empty.
+    bst(bst && other) : cmp(other.cmp) {
+      root = nullptr;
+      max_dead = 0;
+      _init_pool();
+      swap(other);
+    }
+
+    // copy and move assignment (copy-and-swap:  the argument is
+    //   copy- or move-constructed, then traded with *this).
+    bst & operator=(bst other){
+      swap(other);
+      return *this;
+    }
+
+    // O(1) exchange of the contents of two trees.
+    void swap(bst & other){
+      std::swap(cmp, other.cmp);
+      std::swap(root, other.root);
+      std::swap(blocks, other.blocks);
+      std::swap(free_list, other.free_list);
+      std::swap(next_slot, other.next_slot);
+      std::swap(slots_left, other.slots_left);
+      std::swap(n_blocks, other.n_blocks);
+      std::swap(n_reserved, other.n_reserved);
+      std::swap(n_live, other.n_live);
+      std::swap(n_dead, other.n_dead);
+      std::swap(max_dead, other.max_dead);
+      finger.swap(other.finger);
+      std::swap(lookup, other.lookup);
     }
 
   private:
-    // helper function which recursively deallocates nodes
-    //   in a tree.
+    void _init_pool(){
+      blocks = nullptr;
+      free_list = nullptr;
+      next_slot = nullptr;
+      slots_left = 0;
+      n_blocks = 0;
+      n_reserved = 0;
+      n_live = 0;
+      n_dead = 0;
+    }
+
+    // adds a block of cap fresh slots and makes it the one
+    //   _new_node bump-allocates from.
+    void _add_block(int cap){
+      node_block *b = new node_block;
+
+      b->slots = static_cast<bst_node *>(
+          ::operator new(cap * sizeof(bst_node)));
+      b->capacity = cap;
+      b->next = blocks;
+      blocks = b;
+      next_slot = b->slots;
+      slots_left = cap;
+      n_blocks++;
+      n_reserved += cap;
+    }
+
+    bst_node * _new_node(const T & x){
+      bst_node *r;
+      void *p;
+
+      if(free_list != nullptr){
+        p = free_list;
+        free_list = free_list->next;
+      }
+      else {
+        if(slots_left == 0){
+          // grow geometrically (bounded)
+          _add_block(n_reserved < MIN_BLOCK ? MIN_BLOCK :
+                       n_reserved > MAX_BLOCK ? MAX_BLOCK : n_reserved);
+        }
+        p = next_slot++;
+        slots_left--;
+      }
+      n_live++;
+      BST_PROBE(allocs);
+      r = new (p) bst_node(x, nullptr, nullptr);
+      _init_extra(r, Balance());
+      _update(r);
+      return r;
+    }
+
+    void _free_node(bst_node *r){
+      free_slot *f;
+
+      r->~bst_node();
+      f = reinterpret_cast<free_slot *>(r);
+      f->next = free_list;
+      free_list = f;
+      n_live--;
+      BST_PROBE(frees);
+    }
+
+    // preorder copy of the tree rooted at r (same shape, same
+    //   sizes and counts).
+    bst_node * _copy_nodes(const bst_node *r){
+      bst_node *c;
+
+      if(r == nullptr) return nullptr;
+      c = _new_node(r->val);
+      static_cast<typename Balance::node_base &>(*c) =
+        static_cast<const typename Balance::node_base &>(*r);
+      c->size = r->size;
+      c->count = r->count;
+      c->left = _copy_nodes(r->left);
+      c->right = _copy_nodes(r->right);
+      return c;
+    }
+
+    // helper function which destroys the nodes in a tree (their
+    //   storage belongs to the blocks).  Iterative:  left children
+    //   are rotated up as we go, so no stack is needed however
+    //   deep the tree is.
     static void delete_nodes(bst_node *r){
-      if(r==nullptr) return;
-      delete_nodes(r->left);
-      delete_nodes(r->right);
-      delete r;
+      bst_node *tmp;
+
+      while(r != nullptr){
+        if(r->left != nullptr){
+          tmp = r->left;
+          r->left = tmp->right;
+          tmp->right = r;
+          r = tmp;
+        }
+        else {
+          tmp = r->right;
+          r->~bst_node();
+          r = tmp;
+        }
+      }
+    }
+
+    void _release_blocks(){
+      node_block *b;
+
+      while(blocks != nullptr){
+        b = blocks;
+        blocks = b->next;
+        ::operator delete(b->slots);
+        delete b;
+      }
     }
 
   public:
     // destructor
     ~bst() {
       delete_nodes(root);
+      _release_blocks();
     }
 
   private:
+    // three-way comparison of a and b under cmp
+    int _cmp(const T & a, const T & b) const {
+      BST_PROBE(comparisons);
+      BST_PROBE(visits);
+      return bst_compare<T, Compare>::compare(cmp, a, b);
+    }
+
+    /*
+     * _update:  recomputes the augmented fields of r (size, plus
+     *   whatever the balancing policy keeps) from its children.
+     *   Called bottom-up on every node whose subtree changed.
+     */
+    void _update(bst_node *r){
+      r->size = _size(r->left) + _size(r->right) + r->count;
+      _update_extra(r, Balance());
+    }
+
+    template <typename B>
+    static void _update_extra(bst_node *, B) { }
+
+    // _init_extra:  sets up the policy fields of a brand new node
+    template <typename B>
+    static void _init_extra(bst_node *, B) { }
+
+    static void _init_extra(bst_node *r, bst_treap){
+      r->prio = bst_treap::next_priority();
+    }
+
+    static void _update_extra(bst_node *r, bst_size_balanced){
+      r->nodes = 1 + _nodes(r->left) + _nodes(r->right);
+    }
+
+    static void _update_extra(bst_node *r, bst_weight_balanced){
+      r->nodes = 1 + _nodes(r->left) + _nodes(r->right);
+    }
+
+    static void _update_extra(bst_node *r, bst_avl){
+      int a = _ht(r->left);
+      int b = _ht(r->right);
+
+      r->ht = 1 + (a > b ? a : b);
+    }
+
+    /*
+     * _rebalance:  called on the way back up from an insert/remove
+     *   with the (already updated) root r of a changed subtree;
+     *   returns the root of the subtree after the policy has
+     *   restored its balance condition.
+     */
+    template <typename B>
+    bst_node * _rebalance(bst_node *r, B){
+      return r;
+    }
+
+    bst_node * _rebalance(bst_node *r, bst_size_balanced){
+      if(_sb_ok(r))
+        return r;
+      return _rebuild(r);
+    }
+
+    // treap:  after an insert only the child the new node went
+    //   into can outrank r;  one rotation restores the heap order
+    //   at this level.
+    bst_node * _rebalance(bst_node *r, bst_treap){
+      if(r->left != nullptr && r->left->prio > r->prio)
+        return _rotate_right(r);
+      if(r->right != nullptr && r->right->prio > r->prio)
+        return _rotate_left(r);
+      return r;
+    }
+
+    // avl:  children of r are valid AVL trees whose heights differ
+    //   by at most two;  a single or double rotation towards the
+    //   shorter side makes r's subtree AVL again.
+    bst_node * _rebalance(bst_node *r, bst_avl){
+      int bal = _ht(r->left) - _ht(r->right);
+
+      if(bal > 1){
+        if(_ht(r->left->left) < _ht(r->left->right))
+          r->left = _rotate_left(r->left);
+        return _rotate_right(r);
+      }
+      if(bal < -1){
+        if(_ht(r->right->right) < _ht(r->right->left))
+          r->right = _rotate_right(r->right);
+        return _rotate_left(r);
+      }
+      return r;
+    }
+
+    // weight-balanced:  if one side of r outweighs the other more
+    //   than 3 to 1, rotate it up -- doubly when its inner subtree
+    //   is at least twice as heavy as its outer one.
+    bst_node * _rebalance(bst_node *r, bst_weight_balanced){
+      int wl = _nodes(r->left) + 1;
+      int wr = _nodes(r->right) + 1;
+
+      if(wl > 3*wr){
+        if(_nodes(r->left->right) + 1 >= 2*(_nodes(r->left->left) + 1))
+          r->left = _rotate_left(r->left);
+        return _rotate_right(r);
+      }
+      if(wr > 3*wl){
+        if(_nodes(r->right->left) + 1 >= 2*(_nodes(r->right->right) + 1))
+          r->right = _rotate_right(r->right);
+        return _rotate_left(r);
+      }
+      return r;
+    }
+
+    /*
+     * rotations:  the child on the given side takes r's place and
+     *   r becomes its child;  augmented fields are recomputed
+     *   bottom-up.  Return the new subtree root.
+     *
+     *         r              l
+     *        / \            / \
+     *       l   c    =>     a   r
+     *      / \                 / \
+     *     a   b               b   c
+     */
+    bst_node * _rotate_right(bst_node *r){
+      bst_node *l = r->left;
+
+      BST_PROBE(rotations);
+      r->left = l->right;
+      l->right = r;
+      _update(r);
+      _update(l);
+      return l;
+    }
+
+    bst_node * _rotate_left(bst_node *r){
+      bst_node *rt = r->right;
+
+      BST_PROBE(rotations);
+      r->right = rt->left;
+      rt->left = r;
+      _update(r);
+      _update(rt);
+      return rt;
+    }
+
+    // treap:  joins a and b (every value in a before every value
+    //   in b) into one heap-ordered tree;  O(depth).
+    bst_node * _join(bst_node *a, bst_node *b){
+      if(a == nullptr) return b;
+      if(b == nullptr) return a;
+      if(a->prio > b->prio){
+        a->right = _join(a->right, b);
+        _update(a);
+        return a;
+      }
+      b->left = _join(a, b->left);
+      _update(b);
+      return b;
+    }
+
+    /*
+     * _built:  called on the root of a tree assembled in one go
+     *   (from_sorted_vec, set operations) whose shape ignored the
+     *   policy.  The treap restores heap order by sifting
+     *   priorities (not nodes) down, bottom-up -- O(n).
+     */
+    template <typename B>
+    void _built(bst_node *, B) { }
+
+    void _built(bst_node *r, bst_treap){
+      bst_node *c;
+      unsigned tmp;
+
+      if(r == nullptr) return;
+      _built(r->left, bst_treap());
+      _built(r->right, bst_treap());
+      for(;;){
+        c = r->left;
+        if(r->right != nullptr && (c == nullptr || r->right->prio > c->prio))
+          c = r->right;
+        if(c == nullptr || c->prio <= r->prio)
+          break;
+        tmp = r->prio;
+        r->prio = c->prio;
+        c->prio = tmp;
+        r = c;
+      }
+    }
+
+    // size-/weight-balanced:  number of nodes in tree rooted at r
+    static int _nodes(bst_node *r){
+      if(r==nullptr) return 0;
+      return r->nodes;
+    }
+
+    // avl:  height of tree rooted at r (0 if empty)
+    static int _ht(bst_node *r){
+      if(r==nullptr) return 0;
+      return r->ht;
+    }
+
+    // size-balanced:  is r's subtree within the 2k+1 rule?
+    static bool _sb_ok(bst_node *r){
+      int a = _nodes(r->left);
+      int b = _nodes(r->right);
+
+      return a <= 2*b+1 && b <= 2*a+1;
+    }
+
+    // appends the nodes of tree rooted at r to out in order.
+    static void _collect(bst_node *r, std::vector<bst_node *> &out){
+      if(r==nullptr) return;
+      _collect(r->left, out);
+      out.push_back(r);
+      _collect(r->right, out);
+    }
+
+    // links the sorted nodes a[low..hi] into a perfectly balanced
+    //   tree and returns its root.
+    bst_node * _relink(const std::vector<bst_node *> &a, int low, int hi){
+      int m;
+      bst_node *r;
+
+      if(hi < low) return nullptr;
+      m = (low+hi)/2;
+      r = a[m];
+      r->left  = _relink(a, low, m-1);
+      r->right = _relink(a, m+1, hi);
+      _update(r);
+      return r;
+    }
+
+    // rebuilds the subtree rooted at r perfectly balanced (the
+    //   existing nodes are relinked;  nothing is allocated or
+    //   freed apart from the temporary vector).
+    bst_node * _rebuild(bst_node *r){
+      std::vector<bst_node *> a;
+
+      _collect(r, a);
+      BST_PROBE(rebuilds);
+      BST_PROBE_N(rebuilt_nodes, a.size());
+      return _relink(a, 0, (int)a.size()-1);
+    }
+
+    /*
+     * _splay:  top-down splay of the tree rooted at t around x.
+     *   Brings the node holding x (or the last node on the search
+     *   path for x) to the root and returns it.  Works in one pass
+     *   with no recursion and no parent pointers:  nodes to the left
+     *   of the path are hung off l_tree (along right links), nodes
+     *   to the right off r_tree (along left links);  sizes on those
+     *   two spines are fixed up afterwards.
+     */
+    bst_node * _splay(bst_node *t, const T & x){
+      bst_node *l_tree = nullptr;
+      bst_node *r_tree = nullptr;
+      bst_node **l_hook = &l_tree;   // where the next left piece goes
+      bst_node **r_hook = &r_tree;   // where the next right piece goes
+      bst_node *y;
+      int l_size = 0, r_size = 0;
+      int c;
+
+      for(;;){
+        c = _cmp(x, t->val);
+        if(c < 0){
+          if(t->left == nullptr) break;
+          if(_cmp(x, t->left->val) < 0){
+            // zig-zig:  rotate right
+            BST_PROBE(rotations);
+            y = t->left;
+            t->left = y->right;
+            y->right = t;
+            _update(t);
+            t = y;
+            if(t->left == nullptr) break;
+          }
+          // link right
+          *r_hook = t;
+          r_hook = &t->left;
+          r_size += t->count + _size(t->right);
+          t = t->left;
+        }
+        else if(c > 0){
+          if(t->right == nullptr) break;
+          if(_cmp(x, t->right->val) > 0){
+            // zag-zag:  rotate left
+            BST_PROBE(rotations);
+            y = t->right;
+            t->right = y->left;
+            y->left = t;
+            _update(t);
+            t = y;
+            if(t->right == nullptr) break;
+          }
+          // link left
+          *l_hook = t;
+          l_hook = &t->right;
+          l_size += t->count + _size(t->left);
+          t = t->right;
+        }
+        else
+          break;
+      }
+
+      // l_size/r_size become the full sizes of the two side trees
+      //   once t's own children are hung at their ends.
+      l_size += _size(t->left);
+      r_size += _size(t->right);
+
+      *l_hook = nullptr;
+      *r_hook = nullptr;
+      for(y = l_tree; y != nullptr; y = y->right){
+        y->size = l_size;
+        l_size -= y->count + _size(y->left);
+      }
+      for(y = r_tree; y != nullptr; y = y->left){
+        y->size = r_size;
+        r_size -= y->count + _size(y->right);
+      }
+
+      // assemble
+      *l_hook = t->left;
+      *r_hook = t->right;
+      t->left = l_tree;
+      t->right = r_tree;
+      _update(t);
+      return t;
+    }
 
 /**
  * function:  insert()
@@ -53,58 +1226,337 @@ class bst {
  *
  * notes:     if x is already in tree, no modifications are made.
  */
-    static bst_node * _insert(bst_node *r, T & x, bool &success){
+    bst_node * _insert(bst_node *r, const T & x, bool &success){
+      int c;
+
       if(r == nullptr){
         success = true;
-        return new bst_node(x, nullptr, nullptr);
+        return _new_node(x);
       }
 
-      if(r->val == x){
-        success = false;
+      _prefetch_children(r, prefetch_tag());
+      c = _cmp(x, r->val);
+      if(c == 0){
+        // multiset:  another copy of x is just a bigger count;
+        //   a dead node (lazy removal) comes back to life.
+        success = Multi || r->count == 0;
+        if(success){
+          _revive(r);
+          r->count++;
+          r->size++;
+        }
         return r;
       }
-      if(x < r->val){
+      if(c < 0)
         r->left = _insert(r->left, x, success);
-        return r;
+      else
+        r->right = _insert(r->right, x, success);
+
+      if(success){
+        _update(r);
+        r = _rebalance(r, Balance());
+      }
+      return r;
+    }
+
+    template <typename B>
+    bool _insert_root(const T & x, B){
+      bool success;
+      root = _insert(root, x, success);
+      return success;
+    }
+
+    // splay:  splay x to the root, then split there if x is new.
+    bool _insert_root(const T & x, bst_splay){
+      bst_node *n;
+      int c;
+
+      if(root == nullptr){
+        root = _new_node(x);
+        return true;
+      }
+      root = _splay(root, x);
+      c = _cmp(x, root->val);
+      if(c == 0){
+        if(!Multi && root->count > 0)
+          return false;
+        _revive(root);
+        root->count++;
+        root->size++;
+        return true;
+      }
+      n = _new_node(x);
+      if(c < 0){
+        n->left = root->left;
+        n->right = root;
+        root->left = nullptr;
       }
       else {
-        r->right = _insert(r->right, x, success);
-        return r;
+        n->right = root->right;
+        n->left = root;
+        root->right = nullptr;
+      }
+      _update(root);
+      _update(n);
+      root = n;
+      return true;
+    }
+
+
+  public:
+  /**
+   * function:  insert
+   * desc:      inserts x into BST given by t.  Note that
+   *            a BST stores a SET -- no duplicates.  Thus,
+   *            if x is already in t when call made, no
+   *            modifications to tree result.
+   *
+   *            For a multiset, inserting an existing value
+   *            increments its count and succeeds.
+   *
+   * note:      helper function does most of the work.
+   *
+   */
+   bool insert(const T & x){
+      BST_PROBE_OP(INSERT);
+      finger.clear();
+      _note_insert(x, lookup_policy());
+      return _insert_root(x, Balance());
+   }
+
+/**
+ * function:  contains()
+ * desc:      returns true or false depending on whether x is an
+ *            element of BST (calling object)
+ *
+ */
+    bool contains(const T & x){
+      BST_PROBE_OP(LOOKUP);
+      return _lookup(x, lookup_policy());
+    }
+
+    // contains() calls answered by the lookup cache or filter /
+    //   passed on to the tree (always 0 without one).
+    unsigned long lookup_hits() const {
+      return _hits(lookup_policy());
+    }
+
+    unsigned long lookup_misses() const {
+      return _misses(lookup_policy());
+    }
+
+    // counters of the work done by this tree's operations since it
+    //   was created or reset_metrics() was called (see
+    //   bst_metrics;  all zero unless compiled with BST_METRICS).
+    //   They stay with the object:  swap does not exchange them.
+    bst_metrics metrics() const {
+#ifdef BST_METRICS
+      return metrics_count;
+#else
+      return bst_metrics();
+#endif
+    }
+
+    void reset_metrics(){
+#ifdef BST_METRICS
+      metrics_count = bst_metrics();
+#endif
+    }
+
+    /**
+     * function:  memory_usage
+     * desc:      reports the memory the tree holds (see bst_memory).
+     *            O(1):  computed from the pool counters.
+     */
+    bst_memory memory_usage() const {
+      bst_memory m;
+
+      m.nodes = n_live;
+      m.dead_nodes = n_dead;
+      m.node_bytes = sizeof(bst_node);
+      m.blocks = n_blocks;
+      m.reserved_bytes = (size_t)n_reserved * sizeof(bst_node) +
+                         (size_t)n_blocks * sizeof(node_block);
+      m.used_bytes = m.nodes * m.node_bytes;
+      m.unused_slots = slots_left;
+      m.free_slots = n_reserved - slots_left - n_live;
+      m.other_bytes = sizeof(*this) +
+                      finger.capacity() * sizeof(finger_step) +
+                      _lookup_bytes(lookup_policy());
+      m.fragmentation = m.free_slots == 0 ? 0.0 :
+          (double)m.free_slots / (m.nodes + m.free_slots);
+      return m;
+    }
+
+  private:
+    // policies without state (bst_no_lookup) use the
+    //   generic versions of the hooks below
+    template <typename L>
+    bool _lookup(const T & x, L){
+      return _contains(x, Balance());
+    }
+
+    template <int Sets>
+    bool _lookup(const T & x, bst_lookup_cache<Sets>){
+      typedef typename lookup_policy::template table<T>::entry entry;
+      size_t set = std::hash<T>()(x) % Sets;
+      entry *e = &lookup.slots[2*set];
+      int w;
+      bool found;
+
+      for(w=0; w<2; w++){
+        if(e[w].version == lookup.version &&
+            _cmp(x, bst_cache_key<T>::key(e[w].key)) == 0){
+          lookup.hits++;
+          lookup.last[set] = w;
+          return e[w].found;
+        }
+      }
+      lookup.misses++;
+      found = _contains(x, Balance());
+      w = 1 - lookup.last[set];
+      bst_cache_key<T>::store(e[w].key, x);
+      e[w].version = lookup.version;
+      e[w].found = found;
+      lookup.last[set] = w;
+      return found;
+    }
+
+    template <int Bits, typename H>
+    bool _lookup(const T & x, bst_bloom_filter<Bits, H>){
+      if(lookup.dirty){
+        lookup.reset(_size(root));
+        _filter_add(root);
       }
+      if(!lookup.may_contain(_hash(x, lookup_policy()))){
+        lookup.hits++;
+        return false;
+      }
+      lookup.misses++;
+      return _contains(x, Balance());
+    }
+
+    template <int Bits, typename H>
+    static size_t _hash(const T & x, bst_bloom_filter<Bits, H>){
+      return typename bst_bloom_filter<Bits, H>::template
+          hasher<T>::type()(x);
+    }
+
+    void _filter_add(const bst_node *r){
+      if(r == nullptr) return;
+      _filter_add(r->left);
+      if(r->count > 0)
+        lookup.add(_hash(r->val, lookup_policy()));
+      _filter_add(r->right);
+    }
+
+    /*
+     * _note_insert / _note_remove:  x is about to be inserted / has
+     *   just been removed (a remove that found nothing is not
+     *   noted).  A cache drops all its results;  a filter adds x,
+     *   or counts a stale entry.
+     */
+    template <typename L>
+    void _note_insert(const T &, L) { }
+
+    template <int Sets>
+    void _note_insert(const T &, bst_lookup_cache<Sets>){
+      lookup.version++;
+    }
+
+    template <int Bits, typename H>
+    void _note_insert(const T & x, bst_bloom_filter<Bits, H>){
+      if(lookup.dirty)
+        return;
+      if(lookup.keys >= lookup.capacity)
+        lookup.dirty = true;
+      else
+        lookup.add(_hash(x, lookup_policy()));
+    }
+
+    template <typename L>
+    void _note_remove(const T &, L) { }
+
+    template <int Sets>
+    void _note_remove(const T &, bst_lookup_cache<Sets>){
+      lookup.version++;
+    }
+
+    template <int Bits, typename H>
+    void _note_remove(const T &, bst_bloom_filter<Bits, H>){
+      if(++lookup.stale * 4 > lookup.capacity)
+        lookup.dirty = true;
+    }
+
+    template <typename L>
+    unsigned long _hits(L) const {
+      return 0;
+    }
+
+    template <int Sets>
+    unsigned long _hits(bst_lookup_cache<Sets>) const {
+      return lookup.hits;
+    }
+
+    template <int Bits, typename H>
+    unsigned long _hits(bst_bloom_filter<Bits, H>) const {
+      return lookup.hits;
+    }
+
+    template <typename L>
+    unsigned long _misses(L) const {
+      return 0;
+    }
+
+    template <int Sets>
+    unsigned long _misses(bst_lookup_cache<Sets>) const {
+      return lookup.misses;
+    }
+
+    template <int Bits, typename H>
+    unsigned long _misses(bst_bloom_filter<Bits, H>) const {
+      return lookup.misses;
+    }
+
+    // heap bytes of the lookup policy's table
+    template <typename L>
+    size_t _lookup_bytes(L) const {
+      return 0;
+    }
+
+    template <int Sets>
+    size_t _lookup_bytes(bst_lookup_cache<Sets>) const {
+      return lookup.slots.capacity() * sizeof(lookup.slots[0]) +
+             lookup.last.capacity();
+    }
+
+    template <int Bits, typename H>
+    size_t _lookup_bytes(bst_bloom_filter<Bits, H>) const {
+      return lookup.bits.capacity() * sizeof(lookup.bits[0]);
     }
 
+    // bst_prefetch_with:  starts loading both children of r
+    static void _prefetch_children(const bst_node *, std::false_type) { }
 
-  public:
-  /**
-   * function:  insert
-   * desc:      inserts x into BST given by t.  Note that
-   *            a BST stores a SET -- no duplicates.  Thus,
-   *            if x is already in t when call made, no
-   *            modifications to tree result.
-   *
-   * note:      helper function does most of the work.
-   *
-   */
-   bool insert(T & x){
-      bool success;
-      root = _insert(root, x, success);
-      return success;
-   }
+    static void _prefetch_children(const bst_node *r, std::true_type){
+#if defined(__GNUC__)
+      __builtin_prefetch(r->left);
+      __builtin_prefetch(r->right);
+#endif
+    }
 
-/**
- * function:  contains()
- * desc:      returns true or false depending on whether x is an
- *            element of BST (calling object)
- *
- */
-    bool contains(const T & x){
+  private:
+    template <typename B>
+    bool _contains(const T & x, B){
       bst_node *p = root;
+      int c;
 
       while(p != nullptr){
-
-        if(p->val == x)
-          return true;
-        if(x < p->val){
+        _prefetch_children(p, prefetch_tag());
+        c = _cmp(x, p->val);
+        if(c == 0)
+          return p->count > 0;
+        if(c < 0){
           p = p->left;
         }
         else
@@ -113,7 +1565,13 @@ class bst {
       return false;
     }
 
-  private:
+    bool _contains(const T & x, bst_splay){
+      if(root == nullptr)
+        return false;
+      root = _splay(root, x);
+      return _cmp(x, root->val) == 0 && root->count > 0;
+    }
+
     // returns pointer to node containing
     //   smallest value in tree rooted at r
     static bst_node * _min_node(bst_node *r ){
@@ -134,68 +1592,597 @@ class bst {
       return r;
     }
 
-    // recursive helper function for node removal
-    //   returns root of resulting tree after removal.
-    static bst_node * _remove(bst_node *r, T & x, bool &success){
-      bst_node *tmp;
-      bool sanity;
+    /*
+     * Eager removal is iterative:  the path from the root to x is
+     *   recorded in the finger (see finger_step below), the node is
+     *   spliced out, and _finger_fixup then updates and rebalances
+     *   the path bottom-up, as after a finger_insert.  Nothing
+     *   recurses, however deep the tree.
+     *
+     *   for a multiset only one copy of x is removed; the node
+     *   itself goes away when its count drops to zero.
+     */
+    template <typename B>
+    bool _remove_root(const T & x, B){
+      bst_node *p, *c;
+      int d;
 
-      if(r==nullptr){
-        success = false;
-        return nullptr;
+      finger.clear();
+      if(root == nullptr)
+        return false;
+      finger.push_back(finger_step{root, -1, -1});
+      for(;;){
+        p = finger.back().node;
+        d = _cmp(x, p->val);
+        if(d == 0)
+          break;
+        c = d < 0 ? p->left : p->right;
+        if(c == nullptr){
+          finger.clear();
+          return false;
+        }
+        _finger_push(c, d < 0);
       }
-      if(r->val == x){
-        success = true;
+      if(p->count == 0){
+        finger.clear();
+        return false;
+      }
+      if(p->count > 1)
+        p->count--;
+      else if(p->left != nullptr && p->right != nullptr)
+        _splice_out(p, Balance());
+      else {
+        finger.pop_back();
+        _relink_below((int)finger.size() - 1, p,
+            p->left != nullptr ? p->left : p->right);
+        _free_node(p);
+      }
+      if(!finger.empty())
+        _finger_fixup();
+      finger.clear();
+      return true;
+    }
 
-        if(r->left == nullptr){
-          tmp = r->right;
-          delete r;
-          return tmp;
+    // p (the last finger step) has two children:  the successor
+    //   node takes p's place, so no value is copied and surviving
+    //   nodes never move.  The finger is extended down to the
+    //   successor's old parent, with the successor in p's step.
+    template <typename B>
+    void _splice_out(bst_node *p, B){
+      int i = (int)finger.size() - 1;
+      bst_node *m, *q;
+
+      _finger_push(p->right, false);
+      while(finger.back().node->left != nullptr)
+        _finger_push(finger.back().node->left, true);
+      m = finger.back().node;
+      finger.pop_back();
+      q = finger.back().node;
+      if(q == p)
+        p->right = m->right;
+      else
+        q->left = m->right;
+      m->left = p->left;
+      m->right = p->right;
+      _relink_below(i-1, p, m);
+      finger[i].node = m;
+      _free_node(p);
+    }
+
+    // treap:  p's children are merged by priority instead.
+    void _splice_out(bst_node *p, bst_treap){
+      bst_node *r = _join(p->left, p->right);
+
+      finger.pop_back();
+      _relink_below((int)finger.size() - 1, p, r);
+      _free_node(p);
+    }
+
+    // links r where p was:  below finger step i, or at the root
+    //   if i < 0.
+    void _relink_below(int i, bst_node *p, bst_node *r){
+      if(i < 0)
+        root = r;
+      else if(finger[i].node->left == p)
+        finger[i].node->left = r;
+      else
+        finger[i].node->right = r;
+    }
+
+    // splay:  splay x to the root;  if it goes, the left subtree
+    //   is splayed around x as well, which brings its maximum up
+    //   with an empty right link for the right subtree.
+    bool _remove_root(const T & x, bst_splay){
+      bst_node *l;
+
+      if(root == nullptr)
+        return false;
+      root = _splay(root, x);
+      if(_cmp(x, root->val) != 0)
+        return false;
+      if(root->count > 1){
+        root->count--;
+        root->size--;
+        return true;
+      }
+      if(root->left == nullptr)
+        l = root->right;
+      else {
+        l = _splay(root->left, x);
+        l->right = root->right;
+        _update(l);
+      }
+      _free_node(root);
+      root = l;
+      return true;
+    }
+
+  public:
+
+    /**
+     * function:  remove
+     * desc:      removes x from the tree; for a multiset a single
+     *            copy is removed.  returns false if x not present.
+     */
+    bool remove(const T & x){
+      bool removed;
+
+      BST_PROBE_OP(REMOVE);
+      finger.clear();
+      if(max_dead > 0)
+        removed = _remove_lazy(x);
+      else
+        removed = _remove_root(x, Balance());
+      if(removed)
+        _note_remove(x, lookup_policy());
+      return removed;
+    }
+
+    /**
+     * function:  set_lazy_remove
+     * desc:      max_dead > 0 makes remove() LAZY:  when the last
+     *            copy of x goes, its node is only marked dead (count
+     *            0) and the sizes on its path are reduced -- O(h),
+     *            the tree is not restructured, and all size/rank
+     *            queries stay exact.  Inserting a dead value revives
+     *            its node.  Once dead nodes exceed max_dead times the
+     *            nodes in the tree, remove() compacts the tree.
+     *
+     *            max_dead == 0 (the default) compacts and goes back
+     *            to eager removal.
+     */
+    void set_lazy_remove(double _max_dead){
+      max_dead = _max_dead;
+      if(max_dead <= 0 && n_dead > 0){
+        BST_PROBE_AS(REMOVE);
+        _compact();
+      }
+    }
+
+    /**
+     * function:  compact
+     * desc:      frees every dead node and relinks the live ones
+     *            into a perfectly balanced tree, in one O(n) pass.
+     *            Nothing to do if no node is dead.  Counted as a
+     *            REMOVE call (BST_METRICS);  the compactions done by
+     *            remove() and set_lazy_remove() are only charged as
+     *            work to REMOVE.
+     */
+    void compact(){
+      if(n_dead == 0)
+        return;
+      BST_PROBE_OP(REMOVE);
+      _compact();
+    }
+
+  private:
+    // compact() minus the call count, for remove / set_lazy_remove
+    void _compact(){
+      std::vector<bst_node *> a;
+      size_t i;
+      int k = 0;
+
+      finger.clear();
+      a.reserve(n_live);
+      _collect(root, a);
+      for(i=0; i<a.size(); i++){
+        if(a[i]->count == 0)
+          _free_node(a[i]);
+        else
+          a[k++] = a[i];
+      }
+      root = _relink(a, 0, k-1);
+      BST_PROBE(rebuilds);
+      BST_PROBE_N(rebuilt_nodes, k);
+      _built(root, Balance());
+      n_dead = 0;
+    }
+
+    // lazy removal:  finds x, then walks the same path again taking
+    //   one off every size.  No node moves.
+    bool _remove_lazy(const T & x){
+      bst_node *p = root;
+      bst_node *q;
+      int c;
+
+      while(p != nullptr && (c = _cmp(x, p->val)) != 0)
+        p = c < 0 ? p->left : p->right;
+      if(p == nullptr || p->count == 0)
+        return false;
+
+      for(q = root; q != p; q = _cmp(x, q->val) < 0 ? q->left : q->right)
+        q->size--;
+      p->count--;
+      p->size--;
+      if(p->count == 0){
+        n_dead++;
+        if(n_dead > max_dead * n_live)
+          _compact();
+      }
+      return true;
+    }
+
+    // about to add a copy of x at p:  p is no longer dead.
+    void _revive(bst_node *p){
+      if(p->count == 0)
+        n_dead--;
+    }
+
+    // the node holding the largest live value under r, nullptr if
+    //   there is none.  Sizes count live copies only, so no
+    //   comparisons are needed.
+    static bst_node * _max_live(bst_node *r){
+      while(r != nullptr && r->size > 0){
+        if(_size(r->right) > 0)
+          r = r->right;
+        else if(r->count > 0)
+          return r;
+        else
+          r = r->left;
+      }
+      return nullptr;
+    }
+
+  private:
+    /*
+     * The finger:  the root-to-node path left by the last
+     *   finger_insert/append_max.  Step j records the node at depth
+     *   j and the indices (in the finger) of the nearest ancestors
+     *   bounding its subtree from below (lo) and above (hi), -1 if
+     *   unbounded.  A step is reached through a left link exactly
+     *   when its hi is the step above it.
+     */
+    struct finger_step {
+      bst_node *node;
+      int lo;
+      int hi;
+    };
+
+    // can x lie in the subtree of step s?
+    bool _in_range(const finger_step & s, const T & x) const {
+      return (s.lo < 0 || _cmp(x, finger[s.lo].node->val) > 0) &&
+             (s.hi < 0 || _cmp(x, finger[s.hi].node->val) < 0);
+    }
+
+    // appends the step for child c of the last finger node
+    //   (left child if left is true).
+    void _finger_push(bst_node *c, bool left){
+      finger_step s = finger.back();
+      int top = (int)finger.size() - 1;
+
+      if(left)
+        s.hi = top;
+      else
+        s.lo = top;
+      s.node = c;
+      finger.push_back(s);
+    }
+
+    /*
+     * _finger_fixup:  after a node was added (or a count bumped) at
+     *   the end of the finger, updates and rebalances every node of
+     *   the finger bottom-up, relinking any subtree root the policy
+     *   replaced.  Every size on the path changes, so this is O(h)
+     *   whatever the finger saved on comparisons.
+     *
+     *   Only the steps below the highest restructured one can be
+     *   stale (rotations and rebuilds move nodes below the new
+     *   subtree root, which itself keeps the range of the old one),
+     *   so the finger is cut just below it;  the steps above are
+     *   untouched and stay a genuine path.
+     */
+    void _finger_fixup(){
+      bst_node *p, *nr;
+      int i, moved = -1;
+
+      for(i=(int)finger.size()-1; i>=0; i--){
+        p = finger[i].node;
+        _update(p);
+        nr = _rebalance(p, Balance());
+        if(nr != p){
+          _relink_below(i-1, p, nr);
+          finger[i].node = nr;
+          moved = i;
         }
-        if(r->right == nullptr){
-          tmp = r->left;
-          delete r;
-          return tmp;
-        }
-        // if we get here, r has two children
-        r->val = _min_node(r->right)->val;
-        r->right = _remove(r->right, r->val, sanity);
-        if(!sanity)
-          std::cerr << "ERROR:  remove() failed to delete promoted value?\n";
-        return r;
       }
-      if(x < r->val){
-        r->left = _remove(r->left, x, success);
+      if(moved >= 0)
+        finger.resize(moved + 1);
+    }
+
+    //   at (if given) receives the node holding x afterwards --
+    //   the new one or the one already there.
+    template <typename B>
+    bool _finger_insert(const T & x, B, bst_node **at = nullptr){
+      bst_node *p, *c;
+      int i, d;
+
+      if(root == nullptr){
+        finger.clear();
+        _insert_root(x, Balance());
+        if(at != nullptr)
+          *at = root;
+        return true;
       }
-      else {
-        r->right = _remove(r->right, x, success);
+      if(finger.empty())
+        finger.push_back(finger_step{root, -1, -1});
+
+      // climb to the deepest finger node whose subtree may hold x
+      i = (int)finger.size() - 1;
+      while(i > 0 && !_in_range(finger[i], x))
+        i--;
+      finger.resize(i+1);
+
+      // ... and search down from there
+      for(;;){
+        p = finger.back().node;
+        d = _cmp(x, p->val);
+        if(d == 0){
+          if(at != nullptr)
+            *at = p;
+          if(!Multi && p->count > 0)
+            return false;
+          _revive(p);
+          p->count++;
+          break;
+        }
+        c = d < 0 ? p->left : p->right;
+        if(c == nullptr){
+          c = _new_node(x);
+          if(at != nullptr)
+            *at = c;
+          if(d < 0)
+            p->left = c;
+          else
+            p->right = c;
+          _finger_push(c, d < 0);
+          break;
+        }
+        _finger_push(c, d < 0);
       }
-      return r;
+      _finger_fixup();
+      return true;
+    }
+
+    // splay:  splaying already makes an access near the previous
+    //   one cheap (dynamic finger property).  x ends up at the root.
+    bool _finger_insert(const T & x, bst_splay, bst_node **at = nullptr){
+      bool added = _insert_root(x, bst_splay());
+
+      if(at != nullptr)
+        *at = root;
+      return added;
+    }
+
+    template <typename B>
+    bool _append_max(const T & x, B){
+      bst_node *p, *q;
+      int i, d;
+
+      if(root == nullptr){
+        finger.clear();
+        return _insert_root(x, Balance());
+      }
+      if(finger.empty())
+        finger.push_back(finger_step{root, -1, -1});
+
+      // keep the part of the finger on the right spine (no upper
+      //   bound), then follow right links to the maximum.
+      i = (int)finger.size() - 1;
+      while(i > 0 && finger[i].hi >= 0)
+        i--;
+      finger.resize(i+1);
+      while((p = finger.back().node->right) != nullptr)
+        _finger_push(p, false);
+
+      // a dead maximum (lazy removal) says nothing about the live
+      //   values:  x is checked against the largest live one and,
+      //   as it may then belong below dead nodes (or revive one),
+      //   goes in through the finger.
+      p = finger.back().node;
+      if(p->count == 0){
+        q = _max_live(root);
+        if(q != nullptr && _cmp(x, q->val) <= 0)
+          return false;
+        return _finger_insert(x, B());
+      }
+      d = _cmp(x, p->val);
+      if(d <= 0)
+        return false;
+      p->right = _new_node(x);
+      _finger_push(p->right, false);
+      _finger_fixup();
+      return true;
+    }
 
+    // splay:  after the previous append the maximum is at the root.
+    bool _append_max(const T & x, bst_splay){
+      bst_node *n;
+      int d;
+
+      if(root != nullptr){
+        root = _splay(root, x);
+        d = _cmp(x, root->val);
+        if(_size(root->right) > 0 || (d <= 0 && root->count > 0))
+          return false;
+        // only dead nodes at or above x:  a plain insert places
+        //   (or revives) it among them
+        if(root->right != nullptr || d <= 0)
+          return _insert_root(x, bst_splay());
+      }
+      n = _new_node(x);
+      n->left = root;
+      _update(n);
+      root = n;
+      return true;
     }
 
   public:
+    /**
+     * function:  finger_insert
+     * desc:      same as insert(x), but the search starts from the
+     *            path left by the previous finger_insert/append_max
+     *            instead of the root:  that path is climbed only
+     *            until x falls inside the subtree reached.  For a
+     *            nearly sorted key stream, x is close to the last
+     *            key and costs O(log d) comparisons, d being the
+     *            rank distance between them.  The time is still
+     *            O(log n) (O(h) under bst_unbalanced):  every size
+     *            from the root down changes and every node on the
+     *            path is rebalanced.  The finger saves comparisons,
+     *            which matter when comparing keys is expensive.
+     *
+     *            insert and remove drop the finger;  the next
+     *            finger_insert then starts at the root.
+     */
+    bool finger_insert(const T & x){
+      BST_PROBE_OP(INSERT);
+      _note_insert(x, lookup_policy());
+      return _finger_insert(x, Balance());
+    }
 
-    bool remove(T & x){
-      bool success;
-      root = _remove(root, x, success);
-      return success;
+    /**
+     * function:  append_max
+     * desc:      inserts x, which must be greater than every value
+     *            in the tree, using a single comparison:  the
+     *            descent follows the right spine (reusing the
+     *            finger).  Like finger_insert, O(log n) time for
+     *            the size updates and rebalancing on the path.
+     *            Returns false and leaves the tree unchanged if x
+     *            is not a new maximum.  Only live values count:
+     *            after lazy removals x may be below dead ones
+     *            and is then placed by a finger_insert.
+     *
+     *            e.g. time-series ingest:  t.append_max(ts);
+     */
+    bool append_max(const T & x){
+      BST_PROBE_OP(INSERT);
+      _note_insert(x, lookup_policy());
+      return _append_max(x, Balance());
+    }
+
+    /**
+     * function:  find_or_insert
+     * desc:      finger_insert(x) that hands back the element
+     *            equivalent to x:  the one just inserted (inserted
+     *            set to true) or the one already in the tree
+     *            (inserted false, tree unchanged -- a multiset adds
+     *            a copy instead).  Iterative, like finger_insert.
+     *
+     *            The element stays where it is until it is removed
+     *            (no operation copies values between nodes), so the
+     *            pointer can be kept.  Changing it in a way that
+     *            affects its order is not allowed;  bst_map uses
+     *            this to keep its values next to the keys.
+     */
+    const T * find_or_insert(const T & x, bool & inserted){
+      bst_node *at;
+
+      BST_PROBE_OP(INSERT);
+      _note_insert(x, lookup_policy());
+      inserted = _finger_insert(x, Balance(), &at);
+      return &at->val;
+    }
+
+    /**
+     * function:  find
+     * desc:      pointer to the element equivalent to x, or nullptr
+     *            if x is not in the tree (see find_or_insert).  One
+     *            descent;  the lookup policy is not consulted (its
+     *            cache and filter answer yes/no only).
+     */
+    const T * find(const T & x){
+      bst_node *p;
+
+      BST_PROBE_OP(LOOKUP);
+      p = _find_node(x, Balance());
+      return p == nullptr ? nullptr : &p->val;
+    }
+
+  private:
+    template <typename B>
+    bst_node * _find_node(const T & x, B){
+      bst_node *p = root;
+      int c;
+
+      while(p != nullptr){
+        c = _cmp(x, p->val);
+        if(c == 0)
+          return p->count > 0 ? p : nullptr;
+        p = c < 0 ? p->left : p->right;
+      }
+      return nullptr;
+    }
+
+    // splay:  x is splayed to the root, as by contains()
+    bst_node * _find_node(const T & x, bst_splay){
+      if(root == nullptr)
+        return nullptr;
+      root = _splay(root, x);
+      if(_cmp(x, root->val) != 0 || root->count == 0)
+        return nullptr;
+      return root;
     }
 
+  public:
+
 
   private:
-    // recursive helper function to compute size of
-    //   tree rooted at r
+    // size of tree rooted at r (nullptr-safe);  O(1) since
+    //   every node carries the size of its subtree.
     static int _size(bst_node *r){
       if(r==nullptr) return 0;
-      return _size(r->left) + _size(r->right) + 1;
+      return r->size;
     }
 
   public:
+    // number of elements in the tree (copies included
+    //   for a multiset).
     int size() {
       return _size(root);
     }
 
+    /**
+     * function:  count
+     * desc:      returns the multiplicity of x:  0 or 1 for a set,
+     *            the number of copies of x for a multiset.
+     */
+    int count(const T & x){
+      bst_node *p = root;
+      int c;
+
+      BST_PROBE_OP(LOOKUP);
+      while(p != nullptr){
+        c = _cmp(x, p->val);
+        if(c == 0)
+          return p->count;
+        if(c < 0)
+          p = p->left;
+        else
+          p = p->right;
+      }
+      return 0;
+    }
+
   private:
 
     static int _height(bst_node *r){
@@ -214,14 +2201,22 @@ class bst {
     }
 
     bool min(T & answer) {
-      if(root == nullptr){
+      BST_PROBE_OP(QUERY);
+      if(size() == 0){
         return false;
       }
+      if(n_dead > 0)
+        return _get_ith(1, answer);   // leftmost node may be dead
       answer = _min_node(root)->val;
       return true;
     }
 
     T max() {
+      T answer;
+
+      BST_PROBE_OP(QUERY);
+      if(n_dead > 0 && _get_ith(size(), answer))
+        return answer;
       return _max_node(root)->val;
     }
 
@@ -237,7 +2232,7 @@ class bst {
     }
 
 
-    /* TODO
+    /*
      * Function:  get_ith
      * Description:  determines the ith smallest element in t and
      *    "passes it back" to the caller via the reference parameter x.
@@ -247,11 +2242,157 @@ class bst {
      *    If i is outside this range, false is returned.
      *    Otherwise, true is returned (indicating "success").
      *
+     *    For a multiset every copy has its own rank:  a value
+     *    with count c occupies c consecutive ranks.
+     *
      * Runtime:  O(h) where h is the tree height
      */
     bool get_ith(int i, T &x) {
+      BST_PROBE_OP(QUERY);
+      return _get_ith(i, x);
+    }
+
+  private:
+    bool _get_ith(int i, T &x) {
+      bst_node *p = root;
+      int l_size;
+
+      if(i < 1 || i > size())
+        return false;
+
+      while(p != nullptr){
+        BST_PROBE(visits);
+        l_size = _size(p->left);
+        if(i <= l_size)
+          p = p->left;
+        else if(i <= l_size + p->count){
+          x = p->val;
+          _accessed(p, Balance());
+          return true;
+        }
+        else {
+          i -= l_size + p->count;
+          p = p->right;
+        }
+      }
+      return false;   // should never happen!
+    }
+
+  public:
+
+
+    /*
+     * Function:  select_range
+     * Description:  appends the ith through jth smallest elements
+     *    (inclusive, ranks as in get_ith) to out in sorted order.
+     *    Ranks outside 1..n are clipped to that range.
+     *
+     *    One O(h) descent locates rank i;  the remaining elements
+     *    are then produced by an in-order walk from that point
+     *    (ancestors still to be visited are kept on a stack), so
+     *    nothing is searched for twice.
+     *
+     *    returns the number of elements appended.
+     *
+     * Runtime:  O(h + k) where k = j-i+1
+     */
+    int select_range(int i, int j, std::vector<T> &out) {
+      std::vector<bst_node *> pending;   // ancestors we went left at
+      bst_node *p = root;
+      int l_size, skip, k, c, appended;
+
+      BST_PROBE_OP(QUERY);
+      if(i < 1)
+        i = 1;
+      if(j > size())
+        j = size();
+      if(i > j)
+        return 0;
+
+      k = j - i + 1;
+      skip = 0;
+      while(p != nullptr){
+        BST_PROBE(visits);
+        l_size = _size(p->left);
+        if(i <= l_size){
+          pending.push_back(p);
+          p = p->left;
+        }
+        else if(i <= l_size + p->count){
+          skip = i - l_size - 1;   // copies of p->val ranked below i
+          break;
+        }
+        else {
+          i -= l_size + p->count;
+          p = p->right;
+        }
+      }
+
+      appended = 0;
+      out.reserve(out.size() + k);
+      while(appended < k){
+        for(c = p->count - skip; c > 0 && appended < k; c--, appended++)
+          out.push_back(p->val);
+        skip = 0;
+
+        // advance p to its in-order successor
+        if(p->right != nullptr){
+          p = p->right;
+          while(p->left != nullptr){
+            pending.push_back(p);
+            p = p->left;
+          }
+        }
+        else if(!pending.empty()){
+          p = pending.back();
+          pending.pop_back();
+        }
+        else
+          break;
+      }
+      return appended;
+    }
+
+
+    /*
+     * Function:  quantiles
+     * Description:  for each q in qs (0 <= q <= 1) determines the
+     *    element of rank ceil(q*n) (clipped to 1..n -- the
+     *    "nearest rank" definition) and stores it in the
+     *    corresponding position of out (out is resized to match qs).
+     *
+     *    All of the requested ranks are resolved in ONE shared
+     *    descent:  the (sorted) rank set is split at each node into
+     *    the ranks falling left, at the node and right, so the
+     *    top of the tree is visited once rather than once per
+     *    quantile.
+     *
+     *    returns false (and leaves out alone) if the tree is empty.
+     *
+     * Runtime:  O(k log k + visited nodes), at most O(k h)
+     */
+    bool quantiles(const std::vector<double> &qs, std::vector<T> &out) {
+      std::vector<std::pair<int, int> > want;   // (rank, index in qs)
+      int n = size();
+      int r;
+      size_t k;
+
+      BST_PROBE_OP(QUERY);
+      if(n == 0)
+        return false;
+
+      want.reserve(qs.size());
+      for(k=0; k<qs.size(); k++){
+        r = (int)std::ceil(qs[k] * n);
+        if(r < 1) r = 1;
+        if(r > n) r = n;
+        want.push_back(std::make_pair(r, (int)k));
+      }
+      std::sort(want.begin(), want.end());
 
-      return false;   // placeholder
+      out.resize(qs.size());
+      _select_sorted(root, want, 0, want.size(), 0, out);
+      return true;
     }
 
 
@@ -267,7 +2408,7 @@ class bst {
     }
 
 
-    /* TODO
+    /*
      * Function:  num_geq
      * Description:  returns the number of elements in tree which are
      *       greater than or equal to x.
@@ -275,7 +2416,8 @@ class bst {
      * Runtime:  O(h) where h is the tree height
      */
     int num_geq(const T & x) {
-      return 0;  // placeholder
+      BST_PROBE_OP(QUERY);
+      return size() - _num_less(x, Balance());
     }
 
     /*
@@ -288,7 +2430,7 @@ class bst {
     }
 
 
-    /* TODO
+    /*
      * Function:  num_leq
      * Description:  returns the number of elements in tree which are less
      *      than or equal to x.
@@ -297,10 +2439,43 @@ class bst {
      *
      **/
     int num_leq(const T &x) {
+      BST_PROBE_OP(QUERY);
+      return _num_leq(x, Balance());
+    }
+
+  private:
+    template <typename B>
+    int _num_leq(const T &x, B) {
+      bst_node *p = root;
+      int total = 0;
+      int c;
+
+      while(p != nullptr){
+        c = _cmp(x, p->val);
+        if(c < 0)
+          p = p->left;
+        else {
+          total += _size(p->left) + p->count;
+          if(c == 0)
+            break;
+          p = p->right;
+        }
+      }
+      return total;
+    }
 
-      return 0;  // placeholder
+    // splay:  after splaying x the answer can be read off the root
+    int _num_leq(const T &x, bst_splay) {
+      if(root == nullptr)
+        return 0;
+      root = _splay(root, x);
+      if(cmp(x, root->val))
+        return _size(root->left);
+      return _size(root->left) + root->count;
     }
 
+  public:
+
     /*
      * function:     num_leq_SLOW
      * description:  same functionality as num_leq but sloooow (linear time)
@@ -310,7 +2485,7 @@ class bst {
       return _num_leq_SLOW(root, x);
     }
 
-    /* TODO
+    /*
      * Function:  num_range
      * Description:  returns the number of elements in tree which are
      *       between min and max (inclusive).
@@ -318,45 +2493,11 @@ class bst {
      * Runtime:  O(h) where h is the tree height
      *
      **/
-     //Helper fucntion for num_range
-     //Test is t11.cpp
-     //Finish other num_range functions 
-     int _num_range(bst_node *r,const T & min, const T & max){
-       //Empty
-       if(!r)
-         return 0;
-      //Single node
-      if(r->val==max && r->val==min)
-          return 1;
-       //Two children nodes
-       if(r->val >= min && r->val <= max){
-         return (1+_num_range(r->left,min,max)+_num_range(r->right,min,max));
-       }
-       //Right subtree only
-       else if(r->val < min)
-         return _num_range(r->right,min,max);
-       //Left subtee only
-       else
-         return _num_range(r->left,min,max);
-     }
     int num_range(const T & min, const T & max) {
-      bst_node *left = root->left;
-      bst_node *right = root->right;
-      //Empty tree
-      if(!root)
+      BST_PROBE_OP(QUERY);
+      if(cmp(max, min))
         return 0;
-      //Single node
-      if(root->val==max && root->val==min)
-        return 1;
-      //Current node is in range
-      if(root->val<=max && root->val>=min)
-        return (1+_num_range(left,min,max)+_num_range(right,min,max));
-      //Right subrtee only
-      else if(root->val < min)
-        return _num_range(right,min,max);
-      //Left subrtee only
-      else
-        return _num_range(left,min,max);
+      return _num_leq(max, Balance()) - _num_less(min, Balance());
     }
 
 
@@ -371,53 +2512,118 @@ class bst {
 
   private:
 
+    // returns the number of elements in the tree which are
+    //   strictly less than x.  O(h).
+    template <typename B>
+    int _num_less(const T & x, B) {
+      bst_node *r = root;
+      int total = 0;
+
+      while(r != nullptr){
+        BST_PROBE(comparisons);
+        BST_PROBE(visits);
+        if(cmp(r->val, x)){
+          total += _size(r->left) + r->count;
+          r = r->right;
+        }
+        else
+          r = r->left;
+      }
+      return total;
+    }
+
+    int _num_less(const T & x, bst_splay) {
+      if(root == nullptr)
+        return 0;
+      root = _splay(root, x);
+      if(cmp(root->val, x))
+        return _size(root->left) + root->count;
+      return _size(root->left);
+    }
+
+    /*
+     * _accessed:  hook for queries that locate a node without
+     *   going through a policy-specific search (get_ith);  the
+     *   splay policy splays the node to the root so that the
+     *   cost of reaching it is paid for (amortized).
+     */
+    template <typename B>
+    void _accessed(bst_node *, B) { }
+
+    void _accessed(bst_node *p, bst_splay) {
+      root = _splay(root, p->val);
+    }
+
+    // helper for quantiles:  want[lo..hi) are (rank, slot) pairs
+    //   sorted by rank, all falling in the tree rooted at r whose
+    //   elements have ranks base+1 .. base+size(r).  Each element
+    //   found is written to out[slot].
+    static void _select_sorted(bst_node *r,
+        const std::vector<std::pair<int, int> > &want, size_t lo, size_t hi,
+        int base, std::vector<T> &out) {
+      size_t m, e;
+      int l_end;
+
+      if(r == nullptr || lo >= hi)
+        return;
+
+      l_end = base + _size(r->left);   // last rank in left subtree
+      for(m=lo; m<hi && want[m].first <= l_end; m++)
+        ;
+      _select_sorted(r->left, want, lo, m, base, out);
+
+      for(e=m; e<hi && want[e].first <= l_end + r->count; e++)
+        out[want[e].second] = r->val;
+
+      _select_sorted(r->right, want, e, hi, l_end + r->count, out);
+    }
 
     static void _get_ith_SLOW(bst_node *t, int i, T &x, int &sofar) {
       if(t==nullptr)
         return;
       _get_ith_SLOW(t->left, i, x, sofar);
 
-      if(sofar==i)
+      if(sofar>=i)
         return;
-      sofar++;
-      if(sofar==i) {
+      sofar += t->count;
+      if(sofar>=i) {
         x = t->val;
         return;
       }
       _get_ith_SLOW(t->right, i, x, sofar);
     }
 
-    static int _num_geq_SLOW(bst_node * t, const T & x) {
+    int _num_geq_SLOW(bst_node * t, const T & x) {
       int total;
 
       if(t==nullptr) return 0;
       total =_num_geq_SLOW(t->left, x) + _num_geq_SLOW(t->right, x);
 
-      if(t->val >= x)
-        total++;
+      if(!cmp(t->val, x))
+        total += t->count;
       return total;
     }
 
-    static int _num_leq_SLOW(bst_node *t, const T &x) {
+    int _num_leq_SLOW(bst_node *t, const T &x) {
       int total;
 
       if(t==nullptr) return 0;
       total =_num_leq_SLOW(t->left, x) + _num_leq_SLOW(t->right, x);
 
-      if(t->val <= x)
-        total++;
+      if(!cmp(x, t->val))
+        total += t->count;
       return total;
     }
 
-    static int _num_range_SLOW(bst_node *t, const T &min, const T &max) {
+    int _num_range_SLOW(bst_node *t, const T &min, const T &max) {
       int total;
 
       if(t==nullptr) return 0;
       total =_num_range_SLOW(t->left, min, max) +
                 _num_range_SLOW(t->right, min, max);
 
-      if(t->val >= min && t->val <= max)
-        total++;
+      if(!cmp(t->val, min) && !cmp(max, t->val))
+        total += t->count;
       return total;
     }
 
@@ -426,65 +2632,365 @@ class bst {
 
 
   private:
-    static void indent(int m){
-      int i;
-      for(i=0; i<m; i++)
-        std::cout << "-";
+    /*
+     * Traversals are iterative.  The pending nodes are kept in a
+     *   walk_stack:  an array on the C++ stack deep enough for any
+     *   tree the height-balancing policies can build, which spills
+     *   into a vector only for deeper (unbalanced, splay) trees.
+     *   Level order keeps its nodes in a walk_queue, a ring buffer
+     *   that likewise moves into a vector once it outgrows INLINE.
+     */
+    struct walk_frame {
+      const bst_node *node;
+      int depth;
+      int stage;   // children already pushed (postorder, dump)
+    };
+
+    struct walk_stack {
+      static const int INLINE = 96;
+
+      walk_frame              frames[INLINE];
+      std::vector<walk_frame> spill;   // frames beyond INLINE
+      int                     n;
+
+      walk_stack() : n(0) { }
+
+      bool empty() const { return n == 0; }
+
+      void push(const bst_node *r, int depth){
+        walk_frame f = { r, depth, 0 };
+
+        if(n < INLINE)
+          frames[n] = f;
+        else
+          spill.push_back(f);
+        n++;
+      }
+
+      walk_frame & top(){
+        return n <= INLINE ? frames[n-1] : spill.back();
+      }
+
+      walk_frame pop(){
+        walk_frame f = top();
+
+        if(n > INLINE)
+          spill.pop_back();
+        n--;
+        return f;
+      }
+    };
+
+    struct walk_queue {
+      static const size_t INLINE = 128;   // a power of two
+
+      const bst_node *              slots[INLINE];
+      std::vector<const bst_node *> spill;   // the ring once it grew
+      const bst_node **             ring;    // slots or spill.data()
+      size_t                        cap;     // size of ring
+      size_t                        head;    // index of the oldest node
+      size_t                        n;
+
+      walk_queue() : ring(slots), cap(INLINE), head(0), n(0) { }
+
+      walk_queue(const walk_queue &) = delete;
+      walk_queue & operator=(const walk_queue &) = delete;
+
+      bool empty() const { return n == 0; }
+
+      void push(const bst_node *r){
+        if(n == cap)
+          _grow();
+        ring[(head + n) & (cap - 1)] = r;
+        n++;
+      }
+
+      const bst_node * pop(){
+        const bst_node *r = ring[head];
+
+        head = (head + 1) & (cap - 1);
+        n--;
+        return r;
+      }
+
+      // doubles the ring, unwrapping it to start at index 0
+      void _grow(){
+        std::vector<const bst_node *> v(2 * cap);
+        size_t i;
+
+        for(i=0; i<n; i++)
+          v[i] = ring[(head + i) & (cap - 1)];
+        spill.swap(v);
+        ring = spill.data();
+        cap *= 2;
+        head = 0;
+      }
+    };
+
+    /*
+     * _walk_inorder / _walk_preorder / _walk_postorder:  call
+     *   f(node, depth) for each node (dead ones included) in the
+     *   given order, stopping as soon as f returns false.  With
+     *   nulls, f is also called as f(nullptr, depth) for each empty
+     *   subtree, in its place in the order.
+     *
+     *   returns false iff f stopped the walk.
+     */
+    template <typename F>
+    bool _walk_inorder(F && f) const {
+      walk_stack s;
+      const bst_node *p = root;
+      int depth = 0;
+      walk_frame w;
+
+      while(p != nullptr || !s.empty()){
+        for(; p != nullptr; p = p->left, depth++)
+          s.push(p, depth);
+        w = s.pop();
+        if(!f(w.node, w.depth))
+          return false;
+        p = w.node->right;
+        depth = w.depth + 1;
+      }
+      return true;
     }
 
-    static void _inorder(bst_node *r){
-      if(r==nullptr) return;
-      _inorder(r->left);
-      std::cout << "[ " << r->val << " ]\n";
-      _inorder(r->right);
+    template <typename F>
+    bool _walk_preorder(F && f, bool nulls) const {
+      walk_stack s;
+      walk_frame w;
+
+      s.push(root, 0);
+      while(!s.empty()){
+        w = s.pop();
+        if(w.node == nullptr){
+          if(nulls && !f(nullptr, w.depth))
+            return false;
+          continue;
+        }
+        if(!f(w.node, w.depth))
+          return false;
+        s.push(w.node->right, w.depth + 1);
+        s.push(w.node->left, w.depth + 1);
+      }
+      return true;
     }
 
-    static void _preorder(bst_node *r, int margin){
-      if(r==nullptr) {
-        indent(margin);
-        std::cout << " nullptr \n";
+    template <typename F>
+    bool _walk_postorder(F && f, bool nulls) const {
+      walk_stack s;
+      walk_frame w;
+
+      s.push(root, 0);
+      while(!s.empty()){
+        w = s.top();
+        if(w.node != nullptr && w.stage == 0){
+          s.top().stage = 2;
+          s.push(w.node->right, w.depth + 1);
+          s.push(w.node->left, w.depth + 1);
+          continue;
+        }
+        s.pop();
+        if((w.node != nullptr || nulls) && !f(w.node, w.depth))
+          return false;
       }
-      else {
-        indent(margin);
-        std::cout << "[ " << r->val << " ]\n";
-        _preorder(r->left, margin+3);
-        _preorder(r->right, margin+3);
+      return true;
+    }
+
+    // f(x) once per copy of the element held by r (none if dead);
+    //   false if f stopped.
+    template <typename F>
+    static bool _visit_copies(const bst_node *r, F & f){
+      int i;
+
+      for(i=0; i<r->count; i++){
+        if(!f(r->val))
+          return false;
       }
+      return true;
     }
 
-    /*
-     * TODO:
-     * Complete the (recursive) helper function for the post-order traversal.
-     * Remember: the indentation needs to be proportional to the height of the node!
+  public:
+    /**
+     * functions:  visit_inorder, visit_preorder, visit_postorder,
+     *             visit_level_order
+     *
+     * desc:  call f(x) for each element x in the given order (a
+     *        multiset element once per copy).  f returns bool:
+     *        false stops the traversal.  f is a template argument,
+     *        so a lambda is inlined.
+     *
+     *        e.g.  t.visit_inorder([&](const int &x){
+     *                sum += x;  return sum < limit;  });
+     *
+     *        Iterative, and O(n).  Inorder, preorder and postorder
+     *        allocate nothing unless the tree is deeper than
+     *        walk_stack::INLINE;  level order keeps the next nodes
+     *        in a FIFO (walk_queue), on the heap only once more than
+     *        walk_queue::INLINE are waiting -- about the width of the
+     *        widest level.
+     *
+     * returns:  true if every element was visited.
      */
-    static void _postorder(bst_node *r, int margin){
+    template <typename F>
+    bool visit_inorder(F && f) const {
+      return _walk_inorder([&](const bst_node *r, int){
+          return _visit_copies(r, f);
+        });
+    }
+
+    template <typename F>
+    bool visit_preorder(F && f) const {
+      return _walk_preorder([&](const bst_node *r, int){
+          return _visit_copies(r, f);
+        }, false);
+    }
+
+    template <typename F>
+    bool visit_postorder(F && f) const {
+      return _walk_postorder([&](const bst_node *r, int){
+          return _visit_copies(r, f);
+        }, false);
+    }
+
+    template <typename F>
+    bool visit_level_order(F && f) const {
+      walk_queue q;
+      const bst_node *r;
+
+      if(root != nullptr)
+        q.push(root);
+      while(!q.empty()){
+        r = q.pop();
+        if(!_visit_copies(r, f))
+          return false;
+        if(r->left != nullptr)
+          q.push(r->left);
+        if(r->right != nullptr)
+          q.push(r->right);
+      }
+      return true;
+    }
+
+  private:
+    // writes a single node as [ val ] -- multiset nodes holding
+    //   more than one copy as [ val x count ], dead nodes as
+    //   [ val x0 ]
+    static void _dump_node(bst_writer & w, const bst_node *r){
+      w.put("[ ", 2);
+      w.put_value(r->val);
+      if(r->count != 1){
+        w.put(" x", 2);
+        w.put_value(r->count);
+      }
+      w.put(" ]\n", 3);
+    }
+
+    // the indented preorder/postorder line for node (or empty
+    //   subtree) r at depth d
+    static void _dump_indented(bst_writer & w, const bst_node *r, int d){
+      w.fill('-', 3*d);
+      if(r == nullptr)
+        w.put(" nullptr \n");
+      else
+        _dump_node(w, r);
+    }
 
-      std::cout << "\n   WARNING:  POSTORDER UNIMPLEMENTED...\n";
+    // compact form:  val(left,right), a leaf as just val, an empty
+    //   subtree as nothing;  copies as in _dump_node (valxcount).
+    void _dump_compact(bst_writer & w) const {
+      walk_stack s;
+      const bst_node *r;
+
+      s.push(root, 0);
+      while(!s.empty()){
+        r = s.top().node;
+        if(r == nullptr){
+          s.pop();
+          continue;
+        }
+        switch(s.top().stage){
+          case 0:
+            w.put_value(r->val);
+            if(r->count != 1){
+              w.put('x');
+              w.put_value(r->count);
+            }
+            if(r->left == nullptr && r->right == nullptr){
+              s.pop();
+              break;
+            }
+            w.put('(');
+            s.top().stage = 1;
+            s.push(r->left, 0);
+            break;
+          case 1:
+            w.put(',');
+            s.top().stage = 2;
+            s.push(r->right, 0);
+            break;
+          default:
+            w.put(')');
+            s.pop();
+        }
+      }
+      w.put('\n');
     }
 
   public:
+    /**
+     * function:  dump
+     * desc:      writes the tree to w:  by default in the indented
+     *            preorder format of preorder() (without the
+     *            banners);  if compact, on one line as
+     *            val(left,right), e.g. 5(3(1,4),8(,9)).  O(n), and
+     *            the text goes out in buffer-sized chunks.
+     *
+     *            e.g.  bst_writer w(stderr);  t.dump(w, true);
+     */
+    void dump(bst_writer & w, bool compact = false) const {
+      if(compact)
+        _dump_compact(w);
+      else
+        _walk_preorder([&](const bst_node *r, int d){
+            _dump_indented(w, r, d);
+            return true;
+          }, true);
+    }
+
     void inorder() {
-      std::cout << "\n======== BEGIN INORDER ============\n";
-      _inorder(root);
-      std::cout << "\n========  END INORDER  ============\n";
+      bst_writer w(std::cout);
+
+      w.put("\n======== BEGIN INORDER ============\n");
+      _walk_inorder([&](const bst_node *r, int){
+          if(r->count > 0)
+            _dump_node(w, r);
+          return true;
+        });
+      w.put("\n========  END INORDER  ============\n");
     }
 
 
     void preorder() {
+      bst_writer w(std::cout);
 
-      std::cout << "\n======== BEGIN PREORDER ============\n";
-      _preorder(root, 0);
-      std::cout << "\n========  END PREORDER  ============\n";
+      w.put("\n======== BEGIN PREORDER ============\n");
+      dump(w);
+      w.put("\n========  END PREORDER  ============\n");
 
     }
 
     // indentation is proportional to depth of node being printed
     //   depth is #hops from root.
     void postorder() {
+      bst_writer w(std::cout);
 
-      std::cout << "\n======== BEGIN POSTORDER ============\n";
-      _postorder(root, 0);
-      std::cout << "\n========  END POSTORDER  ============\n";
+      w.put("\n======== BEGIN POSTORDER ============\n");
+      _walk_postorder([&](const bst_node *r, int d){
+          _dump_indented(w, r, d);
+          return true;
+        }, true);
+      w.put("\n========  END POSTORDER  ============\n");
 
     }
 
@@ -494,15 +3000,16 @@ class bst {
      * bst_from_sorted_arr(...). The function must return a sub-tree that is
      * perfectly balanced, given a sorted array of elements a.
      */
-    static bst_node * _from_vec(const std::vector<T> &a, int low, int hi){
+    bst_node * _from_vec(const std::vector<T> &a, int low, int hi){
       int m;
       bst_node *root;
 
       if(hi < low) return nullptr;
       m = (low+hi)/2;
-      root = new bst_node(a[m]);
+      root = _new_node(a[m]);
       root->left  = _from_vec(a, low, m-1);
       root->right = _from_vec(a, m+1, hi);
+      _update(root);
       return root;
 
     }
@@ -511,10 +3018,564 @@ class bst {
     static bst * from_sorted_vec(const std::vector<T> &a, int n){
 
       bst * t = new bst();
-      t->root = _from_vec(a, 0, n-1);
+      if(n > 0)
+        t->_add_block(n);
+      t->root = t->_from_vec(a, 0, n-1);
+      t->_built(t->root, Balance());
+      return t;
+    }
+
+    /**
+     * function:  from_unsorted
+     * desc:      builds a perfectly balanced tree from the values of
+     *            a, in any order and with repeats (a multiset keeps
+     *            every copy, a set one of each).  a is consumed.
+     *
+     *            threads (default:  one per core) share the work:
+     *              - each sorts a slice of a, then the slices are
+     *                merged pairwise, the merges of a round running
+     *                side by side;
+     *              - each drops the repeats in its slice, and the
+     *                slices are packed together;
+     *              - the tree is built top-down from the middle
+     *                value, the two halves of each range going to
+     *                different threads until every thread has one.
+     *            All nodes come from one block reserved up front:
+     *            the node of the ith distinct value is slot i, so
+     *            building needs no allocation and no locking.
+     *
+     * Runtime:  O((n log n) / threads + n) for n values
+     */
+    static bst * from_unsorted(std::vector<T> && a, int threads = 0){
+      bst * t = new bst();
+      std::vector<int> counts;
+      int n;
+
+      if(threads <= 0)
+        threads = (int)std::thread::hardware_concurrency();
+      if(threads <= 0)
+        threads = 1;
+      if((int)a.size() < 2 * PARALLEL_GRAIN * threads)
+        threads = 1 + (int)a.size() / (2 * PARALLEL_GRAIN);
+
+      t->_parallel_sort(a, threads);
+      n = t->_parallel_unique(a, counts, threads);
+      if(n > 0){
+        t->_add_block(n);
+        t->root = t->_build_slots(t->next_slot, a, counts, 0, n-1, threads);
+        t->_claim_slots(n);
+      }
+      t->_built(t->root, Balance());
+      std::vector<T>().swap(a);
+      return t;
+    }
+
+  private:
+    // ranges shorter than this are not split between threads
+    static const int PARALLEL_GRAIN = 1 << 14;
+
+    // the n slots at next_slot now hold live nodes
+    void _claim_slots(int n){
+      next_slot += n;
+      slots_left -= n;
+      n_live += n;
+      BST_PROBE_N(allocs, n);
+    }
+
+    // runs f(0) .. f(k-1), each on its own thread (f(0) on this
+    //   one), and waits for all of them
+    template <typename F>
+    static void _fork_join(int k, F f){
+      std::vector<std::thread> pool;
+      int i;
+
+      for(i=1; i<k; i++)
+        pool.push_back(std::thread(f, i));
+      f(0);
+      for(i=0; i<(int)pool.size(); i++)
+        pool[i].join();
+    }
+
+    // sorts a:  k slices sorted in parallel, then merged in rounds
+    void _parallel_sort(std::vector<T> & a, int k){
+      std::vector<size_t> cut(k + 1);
+      Compare c = cmp;
+      int i, w;
+
+      for(i=0; i<=k; i++)
+        cut[i] = a.size() * i / k;
+      _fork_join(k, [&](int j){
+          std::sort(a.begin() + cut[j], a.begin() + cut[j+1], c);
+        });
+      for(w=1; w<k; w*=2){
+        _fork_join((k + 2*w - 1) / (2*w), [&](int j){
+            int lo = 2 * j * w;
+            int mid = std::min(lo + w, k);
+            int hi = std::min(lo + 2 * w, k);
+
+            if(mid < hi)
+              std::inplace_merge(a.begin() + cut[lo], a.begin() + cut[mid],
+                  a.begin() + cut[hi], c);
+          });
+      }
+    }
+
+    /*
+     * _parallel_unique:  a is sorted;  keeps the first of each run of
+     *   equivalent values at the front of a (in order) and returns how
+     *   many there are.  For a multiset counts[i] is the length of the
+     *   run of a[i].  Each of k slices is packed in parallel, then the
+     *   slices are moved together, joining a run cut by a slice
+     *   boundary.  (Compares without _cmp:  the metrics counters are
+     *   not shared between threads.)
+     */
+    bool _same(const T & x, const T & y) const {
+      return bst_compare<T, Compare>::compare(cmp, x, y) == 0;
+    }
+
+    int _parallel_unique(std::vector<T> & a, std::vector<int> & counts,
+        int k){
+      std::vector<size_t> cut(k + 1), kept(k);
+      size_t out = 0, s;
+      int i;
+
+      if(Multi)
+        counts.resize(a.size());
+      for(i=0; i<=k; i++)
+        cut[i] = a.size() * i / k;
+      _fork_join(k, [&](int j){
+          size_t w = cut[j], r;
+
+          for(r=cut[j]; r<cut[j+1]; r++){
+            if(w > cut[j] && _same(a[w-1], a[r])){
+              if(Multi)
+                counts[w-1]++;
+              continue;
+            }
+            if(w != r)
+              a[w] = std::move(a[r]);
+            if(Multi)
+              counts[w] = 1;
+            w++;
+          }
+          kept[j] = w - cut[j];
+        });
+      for(i=0; i<k; i++){
+        s = cut[i];
+        if(out > 0 && kept[i] > 0 && _same(a[out-1], a[s])){
+          if(Multi)
+            counts[out-1] += counts[s];
+          s++;
+        }
+        for(; s < cut[i] + kept[i]; s++, out++){
+          if(out != s){
+            a[out] = std::move(a[s]);
+            if(Multi)
+              counts[out] = counts[s];
+          }
+        }
+      }
+      return (int)out;
+    }
+
+    /*
+     * _build_slots:  perfectly balanced subtree of a[low..hi] whose
+     *   nodes are constructed in slots[low..hi];  the two halves of a
+     *   range are built on separate threads while threads > 1.
+     */
+    bst_node * _build_slots(bst_node *slots, const std::vector<T> &a,
+        const std::vector<int> &counts, int low, int hi, int threads){
+      bst_node *r;
+      int m;
+
+      if(hi < low) return nullptr;
+      m = (low+hi)/2;
+      r = new (slots + m) bst_node(a[m], nullptr, nullptr);
+      _init_extra(r, Balance());
+      if(Multi)
+        r->count = counts[m];
+      if(threads > 1 && hi - low >= 2 * PARALLEL_GRAIN){
+        std::thread left([&]{
+            r->left = _build_slots(slots, a, counts, low, m-1, threads/2);
+          });
+        r->right = _build_slots(slots, a, counts, m+1, hi,
+            threads - threads/2);
+        left.join();
+      }
+      else {
+        r->left  = _build_slots(slots, a, counts, low, m-1, 1);
+        r->right = _build_slots(slots, a, counts, m+1, hi, 1);
+      }
+      _update(r);
+      return r;
+    }
+
+  public:
+
+    /**
+     * function:  insert_sorted
+     * desc:      inserts the values of a, which must be sorted and
+     *            distinct.  The result is the same as inserting them
+     *            one at a time.  Returns the number of elements added.
+     *
+     *            Under bst_size_balanced and bst_unbalanced the whole
+     *            run goes in in ONE merged pass (see _merge_sorted).
+     *            Each node on the union of the search paths is
+     *            updated and checked once, so b values cost
+     *            O(b log(n/b) + b) steps, not b separate descents
+     *            and rebalances.  The rotation-based policies cannot
+     *            be repaired by one check per node, so they
+     *            finger_insert the values in order instead.
+     */
+    int insert_sorted(const std::vector<T> & a){
+      size_t i;
+
+      BST_PROBE_OP(INSERT);
+      finger.clear();
+      for(i=0; i<a.size(); i++)
+        _note_insert(a[i], lookup_policy());
+      return _insert_sorted(a, Balance());
+    }
+
+  private:
+    template <typename B>
+    int _insert_sorted(const std::vector<T> & a, B){
+      size_t i;
+      int added = 0;
+
+      for(i=0; i<a.size(); i++)
+        added += _finger_insert(a[i], Balance());
+      return added;
+    }
+
+    int _insert_sorted(const std::vector<T> & a, bst_size_balanced){
+      int added = 0;
+
+      root = _merge_sorted(root, a, 0, (int)a.size()-1, added);
+      return added;
+    }
+
+    int _insert_sorted(const std::vector<T> & a, bst_unbalanced){
+      int added = 0;
+
+      root = _merge_sorted(root, a, 0, (int)a.size()-1, added);
+      return added;
+    }
+
+    /*
+     * merges the sorted, distinct values a[low..hi] into the tree
+     * rooted at r:  the run is split around r->val and each part
+     * goes down the matching side;  a part that reaches an empty
+     * subtree becomes a perfectly balanced subtree there.  Then r
+     * is updated and rebalanced.  added counts the new elements.
+     *
+     * returns:   root of the resulting tree.
+     */
+    bst_node * _merge_sorted(bst_node *r, const std::vector<T> &a,
+        int low, int hi, int &added){
+      int m, e, mid;
+
+      if(hi < low) return r;
+      if(r == nullptr){
+        added += hi - low + 1;
+        return _from_vec(a, low, hi);
+      }
+
+      // m:  first of a[low..hi] not less than r->val
+      m = low;
+      e = hi + 1;
+      while(m < e){
+        mid = (m + e) / 2;
+        if(_cmp(a[mid], r->val) < 0)
+          m = mid + 1;
+        else
+          e = mid;
+      }
+      e = m;
+      if(m <= hi && _cmp(a[m], r->val) == 0){
+        if(Multi || r->count == 0){
+          _revive(r);
+          r->count++;
+          added++;
+        }
+        e = m + 1;
+      }
+      r->left  = _merge_sorted(r->left, a, low, m-1, added);
+      r->right = _merge_sorted(r->right, a, e, hi, added);
+      _update(r);
+      return _rebalance(r, Balance());
+    }
+
+  public:
+
+    /**
+     * function:  remove_sorted
+     * desc:      removes the values of a, which must be sorted and
+     *            distinct (for a multiset, one copy of each).  The
+     *            result is the same as removing them one at a time.
+     *            Returns the number of elements removed.
+     *
+     *            Under bst_size_balanced with eager removal the run
+     *            comes out in ONE merged pass (see _unmerge_sorted),
+     *            the counterpart of insert_sorted:  b values cost
+     *            O(b log(n/b) + b) steps.  The other policies, and
+     *            lazy removal, remove the values one at a time.
+     */
+    int remove_sorted(const std::vector<T> & a){
+      BST_PROBE_OP(REMOVE);
+      finger.clear();
+      if(max_dead > 0)
+        return _remove_each(a);
+      return _remove_sorted(a, Balance());
+    }
+
+  private:
+    template <typename B>
+    int _remove_sorted(const std::vector<T> & a, B){
+      return _remove_each(a);
+    }
+
+    int _remove_sorted(const std::vector<T> & a, bst_size_balanced){
+      int removed = 0;
+
+      root = _unmerge_sorted(root, a, 0, (int)a.size()-1, removed);
+      return removed;
+    }
+
+    int _remove_each(const std::vector<T> & a){
+      size_t i;
+      int removed = 0;
+
+      for(i=0; i<a.size(); i++){
+        if(max_dead > 0 ? _remove_lazy(a[i]) : _remove_root(a[i], Balance())){
+          _note_remove(a[i], lookup_policy());
+          removed++;
+        }
+      }
+      return removed;
+    }
+
+    /*
+     * removes the sorted, distinct values a[low..hi] from the tree
+     * rooted at r:  the run is split around r->val as in
+     * _merge_sorted and each part goes down the matching side.  If
+     * r loses its last copy it is replaced by its successor (or its
+     * only child).  Then r is updated and rebalanced.  removed counts
+     * the elements removed.
+     *
+     * returns:   root of the resulting tree.
+     */
+    bst_node * _unmerge_sorted(bst_node *r, const std::vector<T> &a,
+        int low, int hi, int &removed){
+      bst_node *c;
+      int m, e, mid;
+      bool hit = false;
+
+      if(hi < low || r == nullptr) return r;
+
+      // m:  first of a[low..hi] not less than r->val
+      m = low;
+      e = hi + 1;
+      while(m < e){
+        mid = (m + e) / 2;
+        if(_cmp(a[mid], r->val) < 0)
+          m = mid + 1;
+        else
+          e = mid;
+      }
+      e = m;
+      if(m <= hi && _cmp(a[m], r->val) == 0){
+        hit = r->count > 0;
+        e = m + 1;
+      }
+      r->left  = _unmerge_sorted(r->left, a, low, m-1, removed);
+      r->right = _unmerge_sorted(r->right, a, e, hi, removed);
+      if(hit){
+        _note_remove(r->val, lookup_policy());
+        removed++;
+        if(--r->count == 0){
+          if(r->left == nullptr || r->right == nullptr){
+            c = r->left != nullptr ? r->left : r->right;
+            _free_node(r);
+            return c;
+          }
+          c = _take_min(r->right);
+          c->left = r->left;
+          c->right = r->right;
+          _free_node(r);
+          r = c;
+        }
+      }
+      _update(r);
+      return _rebalance(r, Balance());
+    }
+
+    // unlinks the minimum node of the nonempty subtree at link and
+    //   returns it;  the nodes on the way down are updated and
+    //   rebalanced bottom-up.
+    bst_node * _take_min(bst_node *&link){
+      std::vector<bst_node **> path;
+      bst_node **p = &link;
+      bst_node *m;
+      int i;
+
+      while((*p)->left != nullptr){
+        path.push_back(p);
+        p = &(*p)->left;
+      }
+      m = *p;
+      *p = m->right;
+      for(i=(int)path.size()-1; i>=0; i--){
+        _update(*path[i]);
+        *path[i] = _rebalance(*path[i], Balance());
+      }
+      return m;
+    }
+
+    // appends pointers to the live nodes of tree rooted at r to
+    //   out in sorted (in-order) order.
+    static void _flatten(const bst_node *r, std::vector<const bst_node *> &out){
+      if(r==nullptr) return;
+      _flatten(r->left, out);
+      if(r->count > 0)
+        out.push_back(r);
+      _flatten(r->right, out);
+    }
+
+    /*
+     * builds a perfectly balanced tree from the sorted run
+     * nodes[low..hi]; node i of the result holds nodes[i]->val
+     * with multiplicity counts[i].
+     */
+    bst_node * _from_nodes(const std::vector<const bst_node *> &nodes,
+        const std::vector<int> &counts, int low, int hi){
+      int m;
+      bst_node *root;
+
+      if(hi < low) return nullptr;
+      m = (low+hi)/2;
+      root = _new_node(nodes[m]->val);
+      root->count = counts[m];
+      root->left  = _from_nodes(nodes, counts, low, m-1);
+      root->right = _from_nodes(nodes, counts, m+1, hi);
+      _update(root);
+      return root;
+    }
+
+    enum set_op { SET_UNION, SET_INTERSECTION, SET_DIFFERENCE };
+
+    /*
+     * merges the in-order streams of *this and b in one linear
+     * pass, keeping per value the multiplicity dictated by op:
+     *
+     *   union:         max(count here, count in b)
+     *   intersection:  min(count here, count in b)
+     *   difference:    count here - count in b (if positive)
+     *
+     * (for sets these are the usual set operations).  The nodes
+     * kept go to nodes, their multiplicities to counts.  The
+     * comparisons are charged to this tree's OTHER counters.
+     */
+    void _merge(const bst &b, set_op op, std::vector<const bst_node *> & nodes,
+        std::vector<int> & counts) const {
+      std::vector<const bst_node *> na, nb;
+      size_t i = 0, j = 0;
+      int c, order;
+
+      BST_PROBE_OP(OTHER);
+      na.reserve(n_live);
+      nb.reserve(b.n_live);
+      _flatten(root, na);
+      _flatten(b.root, nb);
+
+      while(i < na.size() || j < nb.size()){
+        if(i == na.size())
+          order = 1;
+        else if(j == nb.size())
+          order = -1;
+        else
+          order = _cmp(na[i]->val, nb[j]->val);
+
+        if(order < 0){
+          if(op != SET_INTERSECTION){
+            nodes.push_back(na[i]);
+            counts.push_back(na[i]->count);
+          }
+          i++;
+        }
+        else if(order > 0){
+          if(op == SET_UNION){
+            nodes.push_back(nb[j]);
+            counts.push_back(nb[j]->count);
+          }
+          j++;
+        }
+        else {
+          // same value in both
+          if(op == SET_UNION)
+            c = na[i]->count > nb[j]->count ? na[i]->count : nb[j]->count;
+          else if(op == SET_INTERSECTION)
+            c = na[i]->count < nb[j]->count ? na[i]->count : nb[j]->count;
+          else
+            c = na[i]->count - nb[j]->count;
+          if(c > 0){
+            nodes.push_back(na[i]);
+            counts.push_back(c);
+          }
+          i++;
+          j++;
+        }
+      }
+    }
+
+    /*
+     * a op b (see _merge), built as a perfectly balanced tree in a
+     * single block.
+     *
+     * Runtime:  O(n + m)
+     */
+    static bst * _set_op(const bst &a, const bst &b, set_op op){
+      std::vector<const bst_node *> nodes;
+      std::vector<int> counts;
+
+      a._merge(b, op, nodes, counts);
+      bst * t = new bst(a.cmp);
+      if(!nodes.empty())
+        t->_add_block(nodes.size());
+      t->root = t->_from_nodes(nodes, counts, 0, (int)nodes.size()-1);
+      t->_built(t->root, Balance());
       return t;
     }
 
+  public:
+    /*
+     * functions:  set_union, set_intersection, set_difference
+     * desc:       return a NEW balanced tree holding a|b, a&b and
+     *             a-b respectively.  a and b are unchanged.
+     *
+     *             Both trees are assumed to use the same ordering;
+     *             the result uses a's comparator.  Under BST_METRICS
+     *             the merge is an OTHER call on a.
+     *
+     *             For multisets a value's multiplicity in the
+     *             result is the max (union), min (intersection) or
+     *             difference (difference) of its multiplicities.
+     *
+     * Runtime:    O(n + m) -- one merge of the two in-order
+     *             sequences followed by a linear-time build.
+     */
+    static bst * set_union(const bst &a, const bst &b){
+      return _set_op(a, b, SET_UNION);
+    }
+
+    static bst * set_intersection(const bst &a, const bst &b){
+      return _set_op(a, b, SET_INTERSECTION);
+    }
+
+    static bst * set_difference(const bst &a, const bst &b){
+      return _set_op(a, b, SET_DIFFERENCE);
+    }
+
     // TODO:  num_leaves
     //   Hint:  feel free to write a helper function!!
     int num_leaves() {
@@ -536,9 +3597,43 @@ class bst {
 
 
   private:
+    Compare  cmp;
     bst_node *root;
 
+    // node storage (see node_block above)
+    node_block *blocks;
+    free_slot  *free_list;
+    bst_node   *next_slot;    // next never-used slot in newest block
+    int        slots_left;    // never-used slots left in newest block
+    int        n_blocks;
+    int        n_reserved;    // total slots in all blocks
+    int        n_live;        // slots holding a node of the tree
+    int        n_dead;        // ... of which dead (lazy removal)
+    double     max_dead;      // see set_lazy_remove;  0:  eager
+
+    std::vector<finger_step> finger;   // see finger_step above
+
+    typename lookup_policy::template table<T> lookup;   // see lookup policies
+
+#ifdef BST_METRICS
+    mutable bst_metrics metrics_count;
+    mutable int         metrics_op = bst_metrics::OTHER;   // charged op
+#endif
+
 
 }; // end class bst
 
+// a bst which keeps duplicates (one node per distinct value)
+template <typename T, typename Compare = std::less<T>,
+          typename Balance = bst_size_balanced,
+          typename Lookup = bst_no_lookup>
+using bst_multiset = bst<T, Compare, true, Balance, Lookup>;
+
+template <typename T, typename Compare, bool Multi, typename Balance,
+          typename Lookup>
+void swap(bst<T, Compare, Multi, Balance, Lookup> & a,
+          bst<T, Compare, Multi, Balance, Lookup> & b){
+  a.swap(b);
+}
+
 #endif
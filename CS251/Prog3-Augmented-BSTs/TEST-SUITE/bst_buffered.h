@@ -0,0 +1,350 @@
+#ifndef _BST_BUFFERED_H
+#define _BST_BUFFERED_H
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+#include "bst.h"
+
+/**
+ * class bst_buffered<T, Compare, Balance>
+ *
+ * General description:  a SET kept as a bst<T, Compare, false, Balance>
+ *    with a write buffer in front of it (as in a B-epsilon tree).
+ *
+ *    insert/remove are BLIND:  they only record "x in" / "x out" in a
+ *    sorted log of pending updates (the latest update of a value
+ *    wins) and do not look at the tree at all, so unlike
+ *    bst::insert/remove they do not report whether x was a member.
+ *    When the log is full it is applied to the tree in one batch
+ *    (flush):
+ *
+ *      - pending removals go out through bst::remove_sorted and
+ *        pending insertions go in through bst::insert_sorted, each
+ *        of which merges the whole sorted batch with the tree in one
+ *        pass (default policy;  see insert_sorted / remove_sorted for
+ *        the others).
+ *
+ *    The log holds up to max(capacity, size()/8) updates, so a batch
+ *    stays large compared to the tree and the merged pass touches
+ *    few nodes per value.
+ *
+ *    contains() answers from the log when x has a pending update,
+ *    from the tree otherwise.  size() and the rank queries need to
+ *    know which pending updates actually change the set;  the first
+ *    such query after a run of updates looks the new log entries up
+ *    in the tree (in sorted order) and builds prefix counts over the
+ *    log, after which each query is O(h + log b).
+ */
+template <typename T, typename Compare = std::less<T>,
+          typename Balance = bst_size_balanced>
+class bst_buffered {
+
+  public:
+    typedef bst<T, Compare, false, Balance> tree_type;
+
+    static const int DEFAULT_CAPACITY = 4096;
+
+    // constructor:  empty set;  the log is flushed once it holds
+    //   max(capacity, size()/8) pending updates.
+    explicit bst_buffered(int capacity = DEFAULT_CAPACITY,
+        const Compare & c = Compare())
+      : tree(c), cmp(c), cap(capacity < 1 ? 1 : capacity),
+        resolved(true)
+    { }
+
+  private:
+    // a pending update of val
+    struct pending_op {
+      T   val;
+      int op;        // +1:  val in the set,  -1:  val out of it
+      int in_tree;   // is val in the tree?  -1:  not looked up yet
+    };
+
+    // pending_op ordering by val
+    struct op_less {
+      Compare cmp;
+
+      op_less(const Compare & c) : cmp(c) { }
+      bool operator()(const pending_op & a, const pending_op & b) const {
+        return cmp(a.val, b.val);
+      }
+    };
+
+    // +1/-1 if o adds/removes an element of the set, else 0
+    static int _delta(const pending_op & o){
+      if(o.op > 0)
+        return o.in_tree ? 0 : 1;
+      return o.in_tree ? -1 : 0;
+    }
+
+    /*
+     * The log is two sorted arrays:  a new value goes into the short
+     *   array recent;  when that fills up (or a query needs the log
+     *   resolved) it is merged into run in one linear pass.  Adding a
+     *   value thus moves O(RECENT + run/RECENT) entries, not O(run).
+     */
+    static const int RECENT = 256;
+
+    typename std::vector<pending_op>::iterator _find(
+        std::vector<pending_op> & v, const T & x){
+      pending_op key;
+
+      key.val = x;
+      return std::lower_bound(v.begin(), v.end(), key, op_less(cmp));
+    }
+
+    // the pending update of x, or nullptr if there is none
+    pending_op * _lookup(const T & x){
+      typename std::vector<pending_op>::iterator it = _find(recent, x);
+
+      if(it != recent.end() && !cmp(x, it->val))
+        return &*it;
+      it = _find(run, x);
+      if(it != run.end() && !cmp(x, it->val))
+        return &*it;
+      return nullptr;
+    }
+
+    void _record(const T & x, int op){
+      pending_op *p = _lookup(x);
+      pending_op o;
+
+      resolved = false;
+      if(p != nullptr){
+        p->op = op;
+        return;
+      }
+      o.val = x;
+      o.op = op;
+      o.in_tree = -1;
+      recent.insert(_find(recent, x), o);
+      if((int)recent.size() >= RECENT)
+        _settle();
+      _maybe_flush();
+    }
+
+    // merges recent into run
+    void _settle(){
+      if(recent.empty())
+        return;
+      scratch.resize(run.size() + recent.size());
+      std::merge(run.begin(), run.end(), recent.begin(), recent.end(),
+          scratch.begin(), op_less(cmp));
+      run.swap(scratch);
+      recent.clear();
+    }
+
+    /*
+     * _resolve:  settles the log, looks up every entry not yet
+     *   checked against the tree (in sorted order) and rebuilds the
+     *   prefix counts:
+     *     net[k]:   change in size due to run[0..k]
+     *     added[k]: entries of run[0..k] that add an element
+     */
+    void _resolve(){
+      size_t k;
+      int s = 0, a = 0;
+
+      if(resolved)
+        return;
+      _settle();
+      net.resize(run.size());
+      added.resize(run.size());
+      for(k=0; k<run.size(); k++){
+        if(run[k].in_tree < 0)
+          run[k].in_tree = tree.contains(run[k].val);
+        s += _delta(run[k]);
+        a += _delta(run[k]) > 0;
+        net[k] = s;
+        added[k] = a;
+      }
+      resolved = true;
+    }
+
+    // net change in size due to the entries of run before index k
+    int _net_before(int k) const {
+      return k == 0 ? 0 : net[k-1];
+    }
+
+    // additions among the entries of run before index k
+    int _added_before(int k) const {
+      return k == 0 ? 0 : added[k-1];
+    }
+
+    void _maybe_flush(){
+      int limit = tree.size() / 8;
+
+      if(pending() >= (limit > cap ? limit : cap))
+        flush();
+    }
+
+  public:
+    /**
+     * function:  insert
+     * desc:      adds x to the set (blind:  no result, see top of
+     *            file).  O(log b) amortized, plus the flushes.
+     */
+    void insert(const T & x){
+      _record(x, 1);
+    }
+
+    /**
+     * function:  remove
+     * desc:      removes x from the set if present (blind).
+     */
+    void remove(const T & x){
+      _record(x, -1);
+    }
+
+    bool contains(const T & x){
+      pending_op *p = _lookup(x);
+
+      if(p != nullptr)
+        return p->op > 0;
+      return tree.contains(x);
+    }
+
+    int size() {
+      _resolve();
+      return tree.size() + (run.empty() ? 0 : net.back());
+    }
+
+    // number of pending (buffered) updates
+    int pending() const {
+      return (int)(recent.size() + run.size());
+    }
+
+    int num_leq(const T & x){
+      pending_op key;
+
+      _resolve();
+      key.val = x;
+      return tree.num_leq(x) + _net_before(std::upper_bound(run.begin(),
+            run.end(), key, op_less(cmp)) - run.begin());
+    }
+
+    int num_geq(const T & x){
+      pending_op key;
+      int total;
+
+      _resolve();
+      key.val = x;
+      total = run.empty() ? 0 : net.back();
+      return tree.num_geq(x) + total - _net_before(std::lower_bound(
+            run.begin(), run.end(), key, op_less(cmp)) - run.begin());
+    }
+
+    int num_range(const T & min, const T & max){
+      if(cmp(max, min))
+        return 0;
+      return num_leq(max) - num_leq(min) + (contains(min) ? 1 : 0);
+    }
+
+    /**
+     * function:  get_ith
+     * desc:      passes back the ith smallest element (1..size()).
+     *            The answer is the smaller of
+     *              - the first tree element t with num_leq(t) >= i,
+     *              - the first pending addition a with
+     *                num_leq(a) >= i
+     *            (if t is pending removal, an addition smaller than t
+     *            accounts for its rank, so t is never chosen).  Both
+     *            are found by binary search:  O(h log n).
+     */
+    bool get_ith(int i, T & x){
+      int lo, hi, mid, k;
+      bool found = false;
+      T y;
+
+      if(i < 1 || i > size())
+        return false;
+      if(run.empty())
+        return tree.get_ith(i, x);
+
+      lo = 1;
+      hi = tree.size();
+      while(lo <= hi){
+        mid = (lo + hi) / 2;
+        tree.get_ith(mid, y);
+        if(num_leq(y) >= i){
+          x = y;
+          found = true;
+          hi = mid - 1;
+        }
+        else
+          lo = mid + 1;
+      }
+
+      // k:  first log entry whose value has rank >= i
+      lo = 0;
+      hi = (int)run.size();
+      while(lo < hi){
+        mid = (lo + hi) / 2;
+        if(num_leq(run[mid].val) >= i)
+          hi = mid;
+        else
+          lo = mid + 1;
+      }
+      // ... then the first addition from k on
+      k = std::upper_bound(added.begin(), added.end(),
+          _added_before(lo)) - added.begin();
+      if(k < (int)run.size() && (!found || cmp(run[k].val, x)))
+        x = run[k].val;
+      return true;
+    }
+
+    /**
+     * function:  flush
+     * desc:      applies all pending updates to the tree in sorted
+     *            order and empties the log (see top of file).
+     */
+    void flush(){
+      std::vector<T> ins, outs;
+      size_t k;
+
+      _settle();
+      for(k=0; k<run.size(); k++){
+        if(run[k].op > 0)
+          ins.push_back(run[k].val);
+        else if(run[k].in_tree != 0)
+          outs.push_back(run[k].val);
+      }
+      tree.remove_sorted(outs);
+      tree.insert_sorted(ins);
+      run.clear();
+      net.clear();
+      added.clear();
+      resolved = true;
+    }
+
+    int height() {
+      flush();
+      return tree.height();
+    }
+
+    void inorder() {
+      flush();
+      tree.inorder();
+    }
+
+    void dump(bst_writer & w, bool compact = false) {
+      flush();
+      tree.dump(w, compact);
+    }
+
+  private:
+    tree_type               tree;
+    Compare                 cmp;
+    int                     cap;
+    std::vector<pending_op> recent;    // sorted, short
+    std::vector<pending_op> run;       // sorted
+    std::vector<pending_op> scratch;   // merge buffer for _settle
+    bool                    resolved;  // net/added up to date?
+    std::vector<int>        net;       // see _resolve
+    std::vector<int>        added;
+
+
+}; // end class bst_buffered
+
+#endif
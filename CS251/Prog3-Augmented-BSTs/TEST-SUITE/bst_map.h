@@ -0,0 +1,199 @@
+#ifndef _BST_MAP_H
+#define _BST_MAP_H
+
+#include <functional>
+#include <iostream>
+#include <type_traits>
+#include <utility>
+#include "bst.h"
+
+/**
+ * bst_map_entry<K, V>
+ *
+ * element of the bst behind a bst_map:  ordered by key alone (see
+ * bst_map_key_compare), the value rides along.  The value is
+ * mutable so that it can be changed in place through the const
+ * element the tree hands out -- it plays no part in the order.
+ *
+ * The key, which every level of a search reads, comes first;  the
+ * value is stored last so that a large V does not push the search
+ * fields of a node apart.
+ */
+template <typename K, typename V>
+struct bst_map_entry {
+  K         key;
+  mutable V value;
+
+  explicit bst_map_entry(const K & k, const V & v = V{})
+    : key(k), value(v)
+  { }
+};
+
+template <typename K, typename V, typename Compare>
+struct bst_map_key_compare {
+  Compare cmp;
+
+  bst_map_key_compare(const Compare & c = Compare()) : cmp(c) { }
+
+  bool operator()(const bst_map_entry<K, V> & a,
+      const bst_map_entry<K, V> & b) const {
+    return cmp(a.key, b.key);
+  }
+};
+
+// entries compare as their keys:  one three-way key comparison
+template <typename K, typename V, typename Compare>
+struct bst_compare<bst_map_entry<K, V>, bst_map_key_compare<K, V, Compare> > {
+  static int compare(const bst_map_key_compare<K, V, Compare> & c,
+      const bst_map_entry<K, V> & a, const bst_map_entry<K, V> & b){
+    return bst_compare<K, Compare>::compare(c.cmp, a.key, b.key);
+  }
+};
+
+/**
+ * class bst_map<K, V, Compare, Balance>
+ *
+ * General description:  ordered key -> value map.  Keys are unique
+ *    and ordered by Compare.
+ *
+ * Underlying organization:  a
+ *    bst<bst_map_entry<K, V>, ..., false, Balance> of (key, value)
+ *    entries ordered by key, so the map gets bst's node pool and
+ *    its balancing policies:  O(log n) per operation whatever the
+ *    order the keys arrive in (bst_size_balanced by default;
+ *    bst_unbalanced is refused).  Inserts go through
+ *    bst::find_or_insert and removes through bst::remove, both
+ *    iterative.
+ *
+ *    Every lookup that hands back a value (find, operator[],
+ *    try_emplace, update) does a single descent and then lets the
+ *    caller read or modify the value IN PLACE -- no remove+insert
+ *    to change a value.  A lookup by key builds a probe entry, so it
+ *    value-initializes one V.
+ *
+ *    Copy, move, assignment and swap are those of the bst.
+ */
+template <typename K, typename V, typename Compare = std::less<K>,
+          typename Balance = bst_size_balanced>
+class bst_map {
+
+  static_assert(!std::is_same<Balance, bst_unbalanced>::value,
+      "bst_map:  needs a balancing policy");
+
+  private:
+    typedef bst_map_entry<K, V>                  entry;
+    typedef bst_map_key_compare<K, V, Compare>   key_compare;
+    typedef bst<entry, key_compare, false, Balance> tree_type;
+
+  public:
+    // constructor:  initializes an empty map
+    bst_map() { }
+
+    // constructor:  empty map ordered by the given comparator
+    explicit bst_map(const Compare & c) : tree(key_compare(c)) { }
+
+    // O(1) exchange of the contents of two maps
+    void swap(bst_map & other){
+      tree.swap(other.tree);
+    }
+
+    /**
+     * function:  find
+     * desc:      returns pointer to the value associated with key
+     *            or nullptr if key is not in the map.  The value may
+     *            be modified through the pointer.
+     */
+    V * find(const K & key){
+      const entry *e = tree.find(entry(key));
+
+      if(e == nullptr)
+        return nullptr;
+      return &e->value;
+    }
+
+    bool contains(const K & key){
+      return tree.find(entry(key)) != nullptr;
+    }
+
+    /**
+     * function:  try_emplace
+     * desc:      inserts (key, v) if key is not already in the map.
+     *            An existing value is left untouched.
+     *
+     * returns:   true if a new entry was created.
+     */
+    bool try_emplace(const K & key, const V & v = V{}){
+      bool inserted;
+
+      tree.find_or_insert(entry(key, v), inserted);
+      return inserted;
+    }
+
+    /**
+     * function:  operator[]
+     * desc:      returns reference to the value associated with key,
+     *            inserting a default-constructed V first if needed.
+     *            e.g. counts[word]++;
+     */
+    V & operator[](const K & key){
+      bool inserted;
+
+      return tree.find_or_insert(entry(key), inserted)->value;
+    }
+
+    /**
+     * function:  update
+     * desc:      if key is present, calls fn(value) on its value in
+     *            place and returns true;  otherwise returns false and
+     *            the map is unchanged.
+     *
+     *            e.g.  m.update(k, [](int &c){ c += 2; });
+     */
+    template <typename F>
+    bool update(const K & key, F fn){
+      V *v = find(key);
+
+      if(v == nullptr)
+        return false;
+      fn(*v);
+      return true;
+    }
+
+    /**
+     * function:  remove
+     * desc:      removes key (and its value) from the map.
+     *            returns false if key not present.
+     */
+    bool remove(const K & key){
+      return tree.remove(entry(key));
+    }
+
+    int size() {
+      return tree.size();
+    }
+
+    int height() {
+      return tree.height();
+    }
+
+    void inorder() {
+      std::cout << "\n======== BEGIN INORDER ============\n";
+      tree.visit_inorder([](const entry & e){
+          std::cout << "[ " << e.key << " : " << e.value << " ]\n";
+          return true;
+        });
+      std::cout << "\n========  END INORDER  ============\n";
+    }
+
+  private:
+    tree_type tree;
+
+}; // end class bst_map
+
+template <typename K, typename V, typename Compare, typename Balance>
+void swap(bst_map<K, V, Compare, Balance> & a,
+          bst_map<K, V, Compare, Balance> & b){
+  a.swap(b);
+}
+
+#endif
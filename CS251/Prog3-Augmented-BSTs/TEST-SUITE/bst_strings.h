@@ -0,0 +1,494 @@
+#ifndef _BST_STRINGS_H
+#define _BST_STRINGS_H
+
+#include <string.h>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "bst.h"
+
+/**
+ * String keys without a heap allocation per node.
+ *
+ *   bst_string_arena    append-only storage for the characters of
+ *                       many strings, in large chunks;  a string
+ *                       added to it never moves.
+ *
+ *   bst_istring         a key referring to characters stored
+ *                       elsewhere (usually an arena), with its first
+ *                       8 bytes cached in the key itself.
+ *
+ *   bst_string_set<B>   a set of strings kept as a
+ *                       bst<bst_istring, ..., B> whose keys live in
+ *                       an arena (its own or a shared one).
+ *
+ *   bst_frozen_strings  read-only sorted snapshot of a set
+ *                       (bst_string_set::freeze) stored front-coded:
+ *                       each string keeps only what differs from
+ *                       its predecessor.
+ *
+ * Comparisons compare the cached prefixes as one integer and only
+ * read the stored characters when the first 8 bytes are equal, so
+ * most levels of a descent never leave the node.  (Keys sharing a
+ * long common prefix, such as URLs of one site, always fall through
+ * to memcmp;  they still save the allocation per key, and freezing
+ * them saves the most.)
+ */
+
+/**
+ * class bst_string_arena
+ *
+ * Append-only character storage.  Strings are never freed one by
+ * one:  the arena releases everything when it goes away.
+ */
+class bst_string_arena {
+
+  public:
+    static const size_t CHUNK = 1 << 16;
+
+    bst_string_arena() : used(0), room(0), cur(nullptr), n_reserved(0) { }
+
+    bst_string_arena(const bst_string_arena &) = delete;
+    bst_string_arena & operator=(const bst_string_arena &) = delete;
+
+    ~bst_string_arena() {
+      size_t i;
+
+      for(i=0; i<chunks.size(); i++)
+        delete [] chunks[i];
+    }
+
+    // copies s[0..n-1] into the arena;  returns where it now lives
+    const char * add(const char *s, size_t n){
+      char *p;
+
+      if(n == 0)
+        return "";     // (no chunk yet:  cur may be nullptr)
+      if(n > room){
+        room = n > CHUNK ? n : CHUNK;
+        cur = new char[room];
+        chunks.push_back(cur);
+        n_reserved += room;
+      }
+      p = cur;
+      memcpy(p, s, n);
+      cur += n;
+      room -= n;
+      used += n;
+      return p;
+    }
+
+    // takes back p[0..n-1] if it was the last string added
+    //   (a key that turned out to be a duplicate).
+    void pop(const char *p, size_t n){
+      if(p + n == cur){
+        cur -= n;
+        room += n;
+        used -= n;
+      }
+    }
+
+    size_t bytes_used() const {
+      return used;
+    }
+
+    size_t bytes_reserved() const {
+      return n_reserved;
+    }
+
+  private:
+    std::vector<char *> chunks;
+    size_t used;        // bytes handed out
+    size_t room;        // bytes left in the newest chunk
+    char   *cur;        // next free byte of the newest chunk
+    size_t n_reserved;
+};
+
+/**
+ * struct bst_istring
+ *
+ * A string key:  len characters at data (not owned), plus their
+ * first 8 bytes packed big-endian into prefix (zero padded), so that
+ * comparing prefixes as integers orders by those bytes.
+ */
+struct bst_istring {
+  unsigned long long prefix;
+  const char         *data;
+  size_t             len;
+
+  bst_istring() : prefix(0), data(""), len(0) { }
+
+  bst_istring(const char *d, size_t n)
+    : prefix(pack(d, n)), data(d), len(n)
+  { }
+
+  static unsigned long long pack(const char *d, size_t n){
+    unsigned long long p = 0;
+    size_t i;
+
+    for(i=0; i<8; i++)
+      p = (p << 8) | (i < n ? (unsigned char)d[i] : 0);
+    return p;
+  }
+
+  // three-way comparison:  the stored bytes are only read when the
+  //   prefixes are equal.
+  static int compare(const bst_istring & a, const bst_istring & b){
+    size_t k = a.len < b.len ? a.len : b.len;
+    int c;
+
+    if(a.prefix != b.prefix)
+      return a.prefix < b.prefix ? -1 : 1;
+    if(k > 8 && (c = memcmp(a.data + 8, b.data + 8, k - 8)) != 0)
+      return c;
+    if(a.len != b.len)
+      return a.len < b.len ? -1 : 1;
+    return 0;
+  }
+
+  bool operator<(const bst_istring & o) const {
+    return compare(*this, o) < 0;
+  }
+
+  bool operator==(const bst_istring & o) const {
+    return compare(*this, o) == 0;
+  }
+
+  std::string str() const {
+    return std::string(data, len);
+  }
+};
+
+inline std::ostream & operator<<(std::ostream & os, const bst_istring & s){
+  return os.write(s.data, s.len);
+}
+
+template <>
+struct bst_compare<bst_istring, std::less<bst_istring> > {
+  static int compare(const std::less<bst_istring> &,
+      const bst_istring & a, const bst_istring & b){
+    return bst_istring::compare(a, b);
+  }
+};
+
+// a lookup cache keeps its own copy of the characters:  queries
+//   search with keys over the caller's std::string
+template <>
+struct bst_cache_key<bst_istring> {
+  typedef std::string type;
+
+  static void store(type & slot, const bst_istring & x){
+    slot.assign(x.data, x.len);
+  }
+
+  static bst_istring key(const type & slot){
+    return bst_istring(slot.data(), slot.size());
+  }
+};
+
+// FNV-1a over the characters (for the hashing lookup policies)
+namespace std {
+  template <>
+  struct hash<bst_istring> {
+    size_t operator()(const bst_istring & s) const {
+      unsigned long long h = 14695981039346656037ULL;
+      size_t i;
+
+      for(i=0; i<s.len; i++){
+        h ^= (unsigned char)s.data[i];
+        h *= 1099511628211ULL;
+      }
+      return (size_t)h;
+    }
+  };
+}
+
+/**
+ * class bst_frozen_strings
+ *
+ * Sorted, read-only sequence of distinct strings, front-coded in
+ * blocks of BLOCK:  the first string of a block is stored whole,
+ * each other one as (length of the prefix it shares with the one
+ * before, remaining length, remaining bytes), lengths as varints.
+ *
+ * get_ith decodes at most one block;  contains/num_leq binary search
+ * the block heads (stored whole, compared in place) and then decode
+ * one block.  O(log(n/BLOCK) + BLOCK) each.
+ */
+class bst_frozen_strings {
+
+  public:
+    static const int BLOCK = 16;
+
+    bst_frozen_strings() : n(0) { }
+
+    // appends s, which must sort after every string already added
+    void append(const char *s, size_t len){
+      size_t shared = 0;
+
+      if(n % BLOCK == 0)
+        heads.push_back(bytes.size());
+      else {
+        while(shared < len && shared < last.size() && s[shared] == last[shared])
+          shared++;
+      }
+      _put_varint(shared);
+      _put_varint(len - shared);
+      bytes.insert(bytes.end(), s + shared, s + len);
+      last.assign(s, len);
+      n++;
+    }
+
+    int size() const {
+      return n;
+    }
+
+    // gives back the slack left by appending
+    void shrink_to_fit(){
+      bytes.shrink_to_fit();
+      heads.shrink_to_fit();
+      std::string().swap(last);
+    }
+
+    // bytes held (the encoded strings and the block index)
+    size_t memory_bytes() const {
+      return bytes.capacity() + heads.capacity() * sizeof(heads[0]);
+    }
+
+    bool get_ith(int i, std::string & out) const {
+      size_t pos;
+      int k;
+
+      if(i < 1 || i > n)
+        return false;
+      pos = heads[(i-1) / BLOCK];
+      for(k=0; k <= (i-1) % BLOCK; k++)
+        pos = _decode(pos, out);
+      return true;
+    }
+
+    // number of strings <= s
+    int num_leq(const std::string & s) const {
+      std::string cur;
+      size_t pos;
+      int b, lo, hi, mid, k, end;
+
+      // b:  last block whose head is <= s
+      lo = 0;
+      hi = (int)heads.size() - 1;
+      b = -1;
+      while(lo <= hi){
+        mid = (lo + hi) / 2;
+        if(_head_cmp(mid, s) <= 0){
+          b = mid;
+          lo = mid + 1;
+        }
+        else
+          hi = mid - 1;
+      }
+      if(b < 0)
+        return 0;
+
+      pos = heads[b];
+      end = (b + 1) * BLOCK < n ? (b + 1) * BLOCK : n;
+      for(k = b * BLOCK; k < end; k++){
+        pos = _decode(pos, cur);
+        if(cur.compare(s) > 0)
+          return k;
+      }
+      return end;
+    }
+
+    bool contains(const std::string & s) const {
+      std::string x;
+      int k = num_leq(s);
+
+      return k > 0 && get_ith(k, x) && x == s;
+    }
+
+  private:
+    void _put_varint(size_t v){
+      while(v >= 0x80){
+        bytes.push_back((char)(v | 0x80));
+        v >>= 7;
+      }
+      bytes.push_back((char)v);
+    }
+
+    size_t _get_varint(size_t & pos) const {
+      size_t v = 0;
+      int shift = 0;
+      unsigned char c;
+
+      do {
+        c = (unsigned char)bytes[pos++];
+        v |= (size_t)(c & 0x7f) << shift;
+        shift += 7;
+      } while(c & 0x80);
+      return v;
+    }
+
+    // decodes the string at pos on top of out (its predecessor);
+    //   returns the position of the next one.
+    size_t _decode(size_t pos, std::string & out) const {
+      size_t shared = _get_varint(pos);
+      size_t rest = _get_varint(pos);
+
+      out.resize(shared);
+      out.append(bytes.data() + pos, rest);
+      return pos + rest;
+    }
+
+    // compares the head of block b (stored whole) with s in place
+    int _head_cmp(int b, const std::string & s) const {
+      size_t pos = heads[b];
+      size_t len;
+      int c;
+
+      _get_varint(pos);   // shared:  always 0
+      len = _get_varint(pos);
+      c = memcmp(bytes.data() + pos, s.data(), len < s.size() ? len : s.size());
+      if(c != 0)
+        return c;
+      return len < s.size() ? -1 : len > s.size() ? 1 : 0;
+    }
+
+    std::vector<char>   bytes;
+    std::vector<size_t> heads;   // offset of each block's first string
+    std::string         last;    // last string appended
+    int                 n;
+};
+
+/**
+ * class bst_string_set<Balance, Lookup>
+ *
+ * General description:  a SET of strings kept as a
+ *    bst<bst_istring, std::less<bst_istring>, false, Balance, Lookup>.
+ *    Inserted strings are copied once into an arena;  the nodes
+ *    hold a bst_istring (prefix, pointer, length) instead of a
+ *    std::string, so there is no allocation per node and most
+ *    comparisons are decided by the cached prefixes.
+ *
+ *    Queries take std::string and search with a key pointing at the
+ *    caller's characters (nothing is copied;  a bst_lookup_cache
+ *    copies the keys it keeps, see bst_cache_key).
+ *
+ *    The arena is append-only:  the characters of removed strings
+ *    stay until the arena goes away.  Several sets may share one
+ *    arena (the constructor's argument), which must outlive them;
+ *    by default a set owns its own.
+ */
+template <typename Balance = bst_size_balanced,
+          typename Lookup = bst_no_lookup>
+class bst_string_set {
+
+  public:
+    typedef bst<bst_istring, std::less<bst_istring>, false, Balance, Lookup>
+      tree_type;
+
+    explicit bst_string_set(bst_string_arena *shared = nullptr)
+      : own(shared == nullptr ? new bst_string_arena : nullptr),
+        arena(shared == nullptr ? own : shared)
+    { }
+
+    bst_string_set(const bst_string_set &) = delete;
+    bst_string_set & operator=(const bst_string_set &) = delete;
+
+    ~bst_string_set() {
+      delete own;
+    }
+
+  private:
+    // a key over the caller's characters, for searching
+    static bst_istring _probe(const std::string & s){
+      return bst_istring(s.data(), s.size());
+    }
+
+  public:
+    /**
+     * function:  insert
+     * desc:      adds s unless already present;  the characters
+     *            are copied into the arena first and taken back if
+     *            s was a duplicate (one descent either way).
+     */
+    bool insert(const std::string & s){
+      const char *p = arena->add(s.data(), s.size());
+
+      if(tree.insert(bst_istring(p, s.size())))
+        return true;
+      arena->pop(p, s.size());
+      return false;
+    }
+
+    bool remove(const std::string & s){
+      return tree.remove(_probe(s));
+    }
+
+    bool contains(const std::string & s){
+      return tree.contains(_probe(s));
+    }
+
+    int size() {
+      return tree.size();
+    }
+
+    int height() {
+      return tree.height();
+    }
+
+    bool get_ith(int i, std::string & x){
+      bst_istring k;
+
+      if(!tree.get_ith(i, k))
+        return false;
+      x.assign(k.data, k.len);
+      return true;
+    }
+
+    int num_leq(const std::string & s){
+      return tree.num_leq(_probe(s));
+    }
+
+    int num_geq(const std::string & s){
+      return tree.num_geq(_probe(s));
+    }
+
+    int num_range(const std::string & min, const std::string & max){
+      return tree.num_range(_probe(min), _probe(max));
+    }
+
+    // the underlying tree (visitors, dump, memory_usage, ...)
+    const tree_type & keys() const {
+      return tree;
+    }
+
+    const bst_string_arena & strings() const {
+      return *arena;
+    }
+
+    /**
+     * function:  freeze
+     * desc:      front-coded snapshot of the current contents
+     *            (see bst_frozen_strings).  O(n + total length).
+     */
+    bst_frozen_strings freeze() const {
+      bst_frozen_strings f;
+
+      tree.visit_inorder([&](const bst_istring & k){
+          f.append(k.data, k.len);
+          return true;
+        });
+      f.shrink_to_fit();
+      return f;
+    }
+
+  private:
+    bst_string_arena *own;     // nullptr if the arena is shared
+    bst_string_arena *arena;
+    tree_type        tree;
+
+
+}; // end class bst_string_set
+
+#endif
@@ -18,7 +18,7 @@
 int test(int h, int n) {
   // BST *t = build_balanced(h);
   //
-  bst<int> *t = build_balanced(h);
+  test_tree *t = build_balanced(h);
 
   int success = 1;
   int i;
@@ -33,7 +33,7 @@
  *
  */
 int test(int h, int n) {
-  bst<int> *t = build_balanced(h);
+  test_tree *t = build_balanced(h);
   int x, passed, i;
 
   passed = 1;
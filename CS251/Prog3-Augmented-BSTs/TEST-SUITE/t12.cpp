@@ -32,7 +32,7 @@ int test(int h, int n) {
   int lo, hi, delta, i, passed;
   
 
-  bst<int> *t = build_balanced(h);
+  test_tree *t = build_balanced(h);
 
   lo = n/5;
   hi = n-lo;
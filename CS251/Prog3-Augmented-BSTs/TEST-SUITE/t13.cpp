@@ -37,7 +37,7 @@ int test(int h, int init_n) {
   int max;
   
 
-  bst<int> *t = build_balanced_rem_evens(h);
+  test_tree *t = build_balanced_rem_evens(h);
                             //   there are 2^h odd entries
                             //    (before and after removing evens)
 
@@ -26,7 +26,7 @@ int test(int n) {
   static int first = 1;
   
 
-  bst<int> *t;
+  test_tree *t;
 
   build_1_N(n, t);
 
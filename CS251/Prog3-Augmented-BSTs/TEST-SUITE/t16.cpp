@@ -25,7 +25,7 @@ int test(int n) {
   int i;
   
 
-  bst<int> *t;
+  test_tree *t;
 
   build_N_1(n, t);
 
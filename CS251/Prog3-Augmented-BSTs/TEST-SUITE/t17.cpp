@@ -0,0 +1,120 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bst.h"
+
+
+#include "_test.h"
+#include "_tutil.h"
+
+
+
+// char *Desc= "multiset test 1";
+
+/* func: build_balanced_multi
+ * desc: same insertion sequence as build_balanced(h) but
+ *       into a multiset with each key inserted k times.
+ *
+ *       keys:  1..2^(h+1)-1, each with count k.
+ */
+bst_multiset<int> * build_balanced_multi(int h, int k) {
+  bst_multiset<int> *t = new bst_multiset<int>();
+  int n, nleaves, i, j, level, start, delta, x;
+
+  nleaves=1;
+  for(i=0; i<h; i++) {
+    nleaves *= 2;
+  }
+  n = 2*nleaves - 1;
+
+  delta=2*nleaves;
+  start=(n+1)/2;
+  for(level=0; level<=h; level++) {
+      for(x=start; x<=n; x+=delta) {
+        for(j=0; j<k; j++)
+          t->insert( x);
+      }
+      delta /= 2;
+      start /= 2;
+  }
+  return t;
+}
+
+/* func: test
+ * desc: builds a balanced multiset holding 1..n three times each.
+ *
+ *       Then:  checks size, count, num_leq, num_range and
+ *              get_ith against the multiplicities.
+ *
+ *       Then:  removes one copy of every even value and
+ *              re-checks num_leq.
+ *
+ *       Runtime:  should be ~nlogn
+ */
+int test(int h, int n) {
+  bst_multiset<int> *t = build_balanced_multi(h, 3);
+  int x, i, y;
+  int success = 1;
+
+  if(t->size() != 3*n)
+    success = 0;
+
+  for(x=1; x<=n; x++) {
+    if(t->count( x) != 3)
+      success = 0;
+    if(t->num_leq( x) != 3*x)
+      success = 0;
+    if(t->num_range( x, x) != 3)
+      success = 0;
+  }
+  for(i=1; i<=3*n; i++) {
+    if(!t->get_ith( i, y) || y != (i+2)/3)
+      success = 0;
+  }
+
+  for(x=2; x<=n; x+=2) {
+    if(!t->remove( x))
+      success = 0;
+  }
+  for(x=1; x<=n; x++) {
+    if(t->num_leq( x) != 3*x - x/2)
+      success = 0;
+  }
+  if(t->num_geq( 1) != 3*n - n/2)
+    success = 0;
+
+  delete t;
+  return success;
+}
+
+
+
+
+int main(int argc, char *argv[]) {
+  int n = __N;
+  int n2 = __N2;
+  int height = __HEIGHT;
+  int height2 = __HEIGHT2;
+  int ntrials = __NTRIALS;
+
+  if(argc > 1)
+    n = atoi(argv[1]);
+  if(argc > 2)
+    ntrials = atoi(argv[2]);
+
+  set_ntrials(ntrials);
+
+
+
+  START("[multiset]: balanced multiset + counted rank queries");
+
+  TEST_RET_MESSAGE(baseline(), "COMPILATION", 1, 1.5);
+  TEST_RET_MESSAGE(test(height, n), "CORRECTNESS-ONLY-TEST", 1, 2.25);
+  TIME_RATIO(test(height, n), test(height2, n2), "", 1, 2.5, 3.75);
+
+
+  report();
+
+  END;
+}
+
@@ -0,0 +1,185 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bst.h"
+#include "bst_map.h"
+
+
+#include "_test.h"
+#include "_tutil.h"
+
+
+
+// char *Desc= "bst_map test 1";
+
+/* func: fill_balanced
+ * desc: same insertion sequence as build_balanced(h), but keys
+ *       are inserted into the map m via operator[] with value
+ *       2*key.
+ *
+ *       keys:  1..2^(h+1)-1
+ */
+template <typename Map>
+void fill_balanced(Map & m, int h) {
+  int n, nleaves, i, level, start, delta, x;
+
+  nleaves=1;
+  for(i=0; i<h; i++) {
+    nleaves *= 2;
+  }
+  n = 2*nleaves - 1;
+
+  delta=2*nleaves;
+  start=(n+1)/2;
+  for(level=0; level<=h; level++) {
+      for(x=start; x<=n; x+=delta) {
+        m[x] = 2*x;
+      }
+      delta /= 2;
+      start /= 2;
+  }
+}
+
+bst_map<int, int> * build_balanced_map(int h) {
+  bst_map<int, int> *m = new bst_map<int, int>();
+
+  fill_balanced(*m, h);
+  return m;
+}
+
+/* func: test
+ * desc: builds a balanced map 1..n -> 2..2n.
+ *
+ *       Then:  bumps every value via operator[] and update(),
+ *              checks try_emplace does not overwrite, checks
+ *              values via find.
+ *
+ *       Then:  removes every even key and checks contains/size.
+ *
+ *       Then:  copy, assignment, move and swap;  a map with a
+ *              descending comparator.
+ *
+ *       Then:  keys inserted in SORTED order (the default map and
+ *              an AVL map) and every other one removed:  the height
+ *              must stay within the size-balanced bound.
+ *
+ *       Runtime:  should be ~nlogn
+ */
+int test(int h, int n) {
+  bst_map<int, int> *m = build_balanced_map(h);
+  int x;
+  int *v;
+  int success = 1;
+
+  if(m->size() != n)
+    success = 0;
+
+  for(x=1; x<=n; x++) {
+    (*m)[x]++;
+    if(!m->update(x, [](int &c){ c += 10; }))
+      success = 0;
+    if(m->try_emplace(x, -1))
+      success = 0;
+  }
+  if(m->update(n+1, [](int &c){ c = 0; }))
+    success = 0;
+
+  for(x=1; x<=n; x++) {
+    v = m->find(x);
+    if(v == nullptr || *v != 2*x + 11)
+      success = 0;
+  }
+
+  for(x=2; x<=n; x+=2) {
+    if(!m->remove(x))
+      success = 0;
+  }
+  for(x=1; x<=n; x++) {
+    if(m->contains(x) != (x%2 == 1))
+      success = 0;
+  }
+  if(m->size() != (n+1)/2)
+    success = 0;
+
+  // copies are deep:  changing one leaves the other alone
+  bst_map<int, int> c(*m);
+  bst_map<int, int> d;
+
+  d = c;
+  c[1] = -1;
+  c.remove(3);
+  v = m->find(1);
+  if(v == nullptr || *v != 13 || !m->contains(3) || !d.contains(3) ||
+      c.size() != m->size() - 1 || *d.find(1) != 13)
+    success = 0;
+  bst_map<int, int> e(std::move(c));
+  swap(d, e);
+  if(c.size() != 0 || d.size() != m->size() - 1 || e.size() != m->size())
+    success = 0;
+
+  // custom order:  descending keys
+  bst_map<int, int, std::greater<int> > g;
+  fill_balanced(g, h);
+  if(g.size() != n || !g.remove(n) || g.remove(n) || *g.find(1) != 2)
+    success = 0;
+
+  // sorted input does not degrade the map
+  bst_map<int, int> s;
+  bst_map<int, int, std::less<int>, bst_avl> a;
+
+  for(x=1; x<=n; x++) {
+    s[x] = x;
+    a[x] = x;
+  }
+  if(s.size() != n || s.height() > max_sb_height(n) ||
+      a.size() != n || a.height() > max_sb_height(n))
+    success = 0;
+  for(x=1; x<=n; x+=2) {
+    if(!s.remove(x) || !a.remove(x))
+      success = 0;
+  }
+  if(s.size() != n/2 || s.height() > max_sb_height(n/2) ||
+      a.size() != n/2 || a.height() > max_sb_height(n/2))
+    success = 0;
+  for(x=1; x<=n; x++) {
+    v = s.find(x);
+    if((v != nullptr) != (x%2 == 0) || (v != nullptr && *v != x) ||
+        a.contains(x) != (x%2 == 0))
+      success = 0;
+  }
+
+  delete m;
+  return success;
+}
+
+
+
+
+int main(int argc, char *argv[]) {
+  int n = __N;
+  int n2 = __N2;
+  int height = __HEIGHT;
+  int height2 = __HEIGHT2;
+  int ntrials = __NTRIALS;
+
+  if(argc > 1)
+    n = atoi(argv[1]);
+  if(argc > 2)
+    ntrials = atoi(argv[2]);
+
+  set_ntrials(ntrials);
+
+
+
+  START("[bst_map]: balanced map + in-place value updates");
+
+  TEST_RET_MESSAGE(baseline(), "COMPILATION", 1, 1.5);
+  TEST_RET_MESSAGE(test(height, n), "CORRECTNESS-ONLY-TEST", 1, 2.25);
+  TIME_RATIO(test(height, n), test(height2, n2), "", 1, 2.5, 3.75);
+
+
+  report();
+
+  END;
+}
+
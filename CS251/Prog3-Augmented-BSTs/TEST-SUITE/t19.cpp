@@ -0,0 +1,94 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bst.h"
+
+
+#include "_test.h"
+#include "_tutil.h"
+
+
+
+// char *Desc= "copy/move test 1";
+
+/* func: test
+ * desc: builds a perfectly balanced BST of height h (values 1..n)
+ *       and makes a deep copy of it.
+ *
+ *       Then:  removes the evens from the copy and checks that
+ *              the original is untouched and that the copy kept
+ *              the original's shape (height).
+ *
+ *       Then:  moves/swaps the trees around and checks that the
+ *              contents follow.
+ *
+ *       Runtime:  should be ~nlogn
+ */
+int test(int h, int n) {
+  bst<int> *t = build_balanced(h);
+  int x;
+  int success = 1;
+
+  bst<int> c(*t);
+
+  if(c.size() != n || c.height() != h)
+    success = 0;
+
+  for(x=2; x<=n; x+=2)
+    c.remove(x);
+
+  for(x=1; x<=n; x++) {
+    if(!t->contains(x))
+      success = 0;
+    if(c.contains(x) != (x%2 == 1))
+      success = 0;
+  }
+
+  bst<int> m(std::move(c));
+  if(c.size() != 0 || m.size() != (n+1)/2)
+    success = 0;
+
+  m.swap(*t);
+  if(m.size() != n || t->size() != (n+1)/2)
+    success = 0;
+
+  c = m;
+  m = std::move(*t);
+  if(c.size() != n || m.size() != (n+1)/2 || m.num_leq(n) != (n+1)/2)
+    success = 0;
+
+  bst_free(t);
+  return success;
+}
+
+
+
+
+int main(int argc, char *argv[]) {
+  int n = __N;
+  int n2 = __N2;
+  int height = __HEIGHT;
+  int height2 = __HEIGHT2;
+  int ntrials = __NTRIALS;
+
+  if(argc > 1)
+    n = atoi(argv[1]);
+  if(argc > 2)
+    ntrials = atoi(argv[2]);
+
+  set_ntrials(ntrials);
+
+
+
+  START("[copy/move]: balanced tree + copy, move, swap");
+
+  TEST_RET_MESSAGE(baseline(), "COMPILATION", 1, 1.5);
+  TEST_RET_MESSAGE(test(height, n), "CORRECTNESS-ONLY-TEST", 1, 2.25);
+  TIME_RATIO(test(height, n), test(height2, n2), "", 1, 2.5, 3.75);
+
+
+  report();
+
+  END;
+}
+
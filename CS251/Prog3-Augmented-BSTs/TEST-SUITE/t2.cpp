@@ -13,7 +13,7 @@
 // char *Desc= "bst_to_array test 2";
 
 int test(int h, int n) {
-  bst<int> *t = build_balanced_rem_evens(h);
+  test_tree *t = build_balanced_rem_evens(h);
   int success = 1;
   int i, tgt;
 
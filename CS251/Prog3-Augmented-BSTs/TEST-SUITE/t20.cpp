@@ -0,0 +1,91 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bst.h"
+
+
+#include "_test.h"
+#include "_tutil.h"
+
+
+
+// char *Desc= "set algebra test 1";
+
+/* func: test
+ * desc: builds a perfectly balanced BST of height h holding 1..n
+ *       and a second one holding only the odd values.
+ *
+ *       Then:  checks union, intersection and difference of the
+ *              two (both ways) for contents, size and balance
+ *              (results are built perfectly balanced).
+ *
+ *       Runtime:  should be ~nlogn (the set operations themselves
+ *                 are linear).
+ */
+int test(int h, int n) {
+  bst<int> *all = build_balanced(h);
+  bst<int> *odds = build_balanced_rem_evens(h);
+  bst<int> *u, *in, *d, *e;
+  int x;
+  int success = 1;
+
+  u = bst<int>::set_union(*odds, *all);
+  in = bst<int>::set_intersection(*all, *odds);
+  d = bst<int>::set_difference(*all, *odds);
+  e = bst<int>::set_difference(*odds, *all);
+
+  if(u->size() != n || in->size() != (n+1)/2 ||
+      d->size() != n/2 || e->size() != 0)
+    success = 0;
+  if(u->height() != h || in->height() != h || d->height() != h-1)
+    success = 0;
+
+  for(x=1; x<=n; x++) {
+    if(!u->contains(x))
+      success = 0;
+    if(in->contains(x) != (x%2 == 1))
+      success = 0;
+    if(d->contains(x) != (x%2 == 0))
+      success = 0;
+  }
+
+  delete all;
+  delete odds;
+  delete u;
+  delete in;
+  delete d;
+  delete e;
+  return success;
+}
+
+
+
+
+int main(int argc, char *argv[]) {
+  int n = __N;
+  int n2 = __N2;
+  int height = __HEIGHT;
+  int height2 = __HEIGHT2;
+  int ntrials = __NTRIALS;
+
+  if(argc > 1)
+    n = atoi(argv[1]);
+  if(argc > 2)
+    ntrials = atoi(argv[2]);
+
+  set_ntrials(ntrials);
+
+
+
+  START("[set algebra]: union / intersection / difference");
+
+  TEST_RET_MESSAGE(baseline(), "COMPILATION", 1, 1.5);
+  TEST_RET_MESSAGE(test(height, n), "CORRECTNESS-ONLY-TEST", 1, 2.25);
+  TIME_RATIO(test(height, n), test(height2, n2), "", 1, 2.5, 3.75);
+
+
+  report();
+
+  END;
+}
+
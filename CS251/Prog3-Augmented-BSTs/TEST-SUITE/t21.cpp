@@ -0,0 +1,82 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bst.h"
+
+
+#include "_test.h"
+#include "_tutil.h"
+
+
+
+// char *Desc= "select_range test 1";
+
+/* func: test
+ * desc: builds a perfectly balanced BST of height h (values 1..n)
+ *       and removes the evens (ith smallest is then 2i-1).
+ *
+ *       Then:  pages through the whole tree 10 elements at a time
+ *              with select_range and checks every element, plus a
+ *              couple of out-of-range requests.
+ *
+ *       Runtime:  should be ~nlogn
+ */
+int test(int h, int n) {
+  bst<int> *t = build_balanced_rem_evens(h);
+  std::vector<int> page;
+  int nodd = (n+1)/2;
+  int i, k;
+  int success = 1;
+
+  for(i=1; i<=nodd; i+=10) {
+    page.clear();
+    k = t->select_range(i, i+9, page);
+    if(k != (i+9 <= nodd ? 10 : nodd-i+1) || (int)page.size() != k)
+      success = 0;
+    for(int r=0; r<k; r++) {
+      if(page[r] != 2*(i+r)-1)
+        success = 0;
+    }
+  }
+
+  page.clear();
+  if(t->select_range(nodd+1, nodd+5, page) != 0 || !page.empty())
+    success = 0;
+  if(t->select_range(-3, 2, page) != 2 || page[0] != 1 || page[1] != 3)
+    success = 0;
+
+  bst_free(t);
+  return success;
+}
+
+
+
+
+int main(int argc, char *argv[]) {
+  int n = __N;
+  int n2 = __N2;
+  int height = __HEIGHT;
+  int height2 = __HEIGHT2;
+  int ntrials = __NTRIALS;
+
+  if(argc > 1)
+    n = atoi(argv[1]);
+  if(argc > 2)
+    ntrials = atoi(argv[2]);
+
+  set_ntrials(ntrials);
+
+
+
+  START("[select_range]: balanced+rem_evens+paged select_range");
+
+  TEST_RET_MESSAGE(baseline(), "COMPILATION", 1, 1.5);
+  TEST_RET_MESSAGE(test(height, n), "CORRECTNESS-ONLY-TEST", 1, 2.25);
+  TIME_RATIO(test(height, n), test(height2, n2), "", 1, 2.5, 3.75);
+
+
+  report();
+
+  END;
+}
+
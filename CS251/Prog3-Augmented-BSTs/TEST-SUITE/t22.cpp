@@ -0,0 +1,85 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "bst.h"
+
+
+#include "_test.h"
+#include "_tutil.h"
+
+
+
+// char *Desc= "quantiles test 1";
+
+/* func: test
+ * desc: builds a perfectly balanced BST of height h (values 1..n;
+ *       the element of rank r is r).
+ *
+ *       Then:  n times, asks for a batch of quantiles (given in
+ *              no particular order) and checks each against the
+ *              nearest rank ceil(q*n).
+ *
+ *       Runtime:  should be ~nlogn
+ */
+int test(int h, int n) {
+  bst<int> *t = build_balanced(h);
+  std::vector<double> qs;
+  std::vector<int> out;
+  int i, r;
+  size_t k;
+  int success = 1;
+
+  qs.push_back(0.99);
+  qs.push_back(0.5);
+  qs.push_back(0.999);
+  qs.push_back(0.0);
+  qs.push_back(0.9);
+  qs.push_back(1.0);
+  qs.push_back(0.5);
+
+  for(i=0; i<n; i++) {
+    if(!t->quantiles(qs, out) || out.size() != qs.size())
+      success = 0;
+    for(k=0; k<qs.size() && success; k++) {
+      r = (int)ceil(qs[k] * n);
+      if(r < 1) r = 1;
+      if(out[k] != r)
+        success = 0;
+    }
+  }
+  bst_free(t);
+  return success;
+}
+
+
+
+
+int main(int argc, char *argv[]) {
+  int n = __N;
+  int n2 = __N2;
+  int height = __HEIGHT;
+  int height2 = __HEIGHT2;
+  int ntrials = __NTRIALS;
+
+  if(argc > 1)
+    n = atoi(argv[1]);
+  if(argc > 2)
+    ntrials = atoi(argv[2]);
+
+  set_ntrials(ntrials);
+
+
+
+  START("[quantiles]: balanced tree + repeated multi-quantile queries");
+
+  TEST_RET_MESSAGE(baseline(), "COMPILATION", 1, 1.5);
+  TEST_RET_MESSAGE(test(height, n), "CORRECTNESS-ONLY-TEST", 1, 2.25);
+  TIME_RATIO(test(height, n), test(height2, n2), "", 1, 2.5, 3.75);
+
+
+  report();
+
+  END;
+}
+
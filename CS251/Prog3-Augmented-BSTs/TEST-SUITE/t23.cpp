@@ -0,0 +1,108 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bst.h"
+
+
+#include "_test.h"
+#include "_tutil.h"
+
+
+
+// char *Desc= "comparator test 1";
+
+/* func: key_str
+ * desc: zero-padded string key for i so that string order
+ *       matches numeric order:  7 -> "url/00007"
+ */
+std::string key_str(int i) {
+  char buf[32];
+
+  sprintf(buf, "url/%05d", i);
+  return std::string(buf);
+}
+
+/* func: test
+ * desc: inserts 1..n in a pseudo-random order into
+ *         - a bst<int, std::greater<int> > (descending order)
+ *         - a bst<std::string> with zero-padded string keys
+ *
+ *       Then:  checks rank queries honour the comparator
+ *              (ith smallest under greater<> is n-i+1) and that
+ *              string keys come back in sorted order.
+ *
+ *       Runtime:  should be ~nlogn (random insertion order)
+ */
+int test(int n) {
+  bst<int, std::greater<int> > desc;
+  bst<std::string> strs;
+  std::string s;
+  int i, x, y;
+  int success = 1;
+
+  _srand(n);
+  for(i=1; i<=n; i++) {
+    x = 1 + _rand() % n;
+    desc.insert(x);
+    strs.insert(key_str(x));
+  }
+  for(x=1; x<=n; x++) {
+    desc.insert(x);
+    strs.insert(key_str(x));
+  }
+
+  if(desc.size() != n || strs.size() != n)
+    success = 0;
+
+  for(i=1; i<=n; i++) {
+    if(!desc.get_ith(i, y) || y != n-i+1)
+      success = 0;
+    if(desc.num_leq(i) != n-i+1)
+      success = 0;
+    if(!strs.get_ith(i, s) || s != key_str(i))
+      success = 0;
+    if(!strs.contains(key_str(i)))
+      success = 0;
+  }
+  if(desc.num_range(n, 1) != n || desc.num_range(1, n) != 0)
+    success = 0;
+
+  for(x=2; x<=n; x+=2) {
+    if(!strs.remove(key_str(x)))
+      success = 0;
+  }
+  if(strs.num_leq(key_str(n)) != (n+1)/2)
+    success = 0;
+
+  return success;
+}
+
+
+
+
+int main(int argc, char *argv[]) {
+  int n = __N;
+  int n2 = __N2;
+  int ntrials = __NTRIALS;
+
+  if(argc > 1)
+    n = atoi(argv[1]);
+  if(argc > 2)
+    ntrials = atoi(argv[2]);
+
+  set_ntrials(ntrials);
+
+
+
+  START("[comparator]: greater<int> and string-keyed trees");
+
+  TEST_RET_MESSAGE(baseline(), "COMPILATION", 1, 1.5);
+  TEST_RET_MESSAGE(test(n), "CORRECTNESS-ONLY-TEST", 1, 2.25);
+  TIME_RATIO(test(n), test(n2), "", 1, 2.5, 3.75);
+
+
+  report();
+
+  END;
+}
+
@@ -0,0 +1,104 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bst.h"
+
+
+#include "_test.h"
+#include "_tutil.h"
+
+
+
+// char *Desc= "weight-balanced policy test 1";
+
+typedef bst<int, std::less<int>, false, bst_weight_balanced> wb_tree;
+
+int lg(int n) {
+  int k = 0;
+
+  while(n > 1) {
+    n /= 2;
+    k++;
+  }
+  return k;
+}
+
+/**
+ * func: test
+ * desc: inserts 1..n in order into a weight-balanced tree
+ *       (the worst case for a plain bst) and checks the
+ *       height bound, looks every key up twice, removes the
+ *       evens, re-checks the height bound and checks contains
+ *       and the rank queries.
+ *
+ *       Overall runtime should be ~NlogN (worst case)
+ *
+ */
+int test(int n) {
+  wb_tree t;
+  int i, x;
+  int success = 1;
+
+  for(i=1; i<=n; i++)
+    t.insert(i);
+
+  // never taller than log_{4/3}(n+1) ~ 2.41 lg(n+1)
+  if(t.height() > (5*lg(n+1))/2)
+    success = 0;
+
+  for(i=1; i<=n; i++) {
+    if(!t.contains(i) || !t.contains(n-i+1))
+      success = 0;
+  }
+  if(t.contains(0) || t.contains(n+1) || t.insert(n/2))
+    success = 0;
+
+  for(i=2; i<=n; i+=2) {
+    if(!t.remove(i))
+      success = 0;
+  }
+  if(t.height() > (5*lg(n+1))/2)
+    success = 0;
+
+  for(i=1; i<=n; i++) {
+    if(t.contains(i) != (i%2 == 1))
+      success = 0;
+    if(t.num_leq(i) != (i+1)/2)
+      success = 0;
+  }
+  for(i=1; i<=(n+1)/2; i++) {
+    if(!t.get_ith(i, x) || x != 2*i-1)
+      success = 0;
+  }
+  return success;
+}
+
+
+
+
+int main(int argc, char *argv[]) {
+  int n = __N;
+  int n2 = __N2;
+  int ntrials = __NTRIALS;
+
+  if(argc > 1)
+    n = atoi(argv[1]);
+  if(argc > 2)
+    ntrials = atoi(argv[2]);
+
+  set_ntrials(ntrials);
+
+
+
+  START("[weight-balanced policy]: insert 1..N, lookups, remove evens, rank queries");
+
+  TEST_RET_MESSAGE(baseline(), "COMPILATION", 1, 1.5);
+  TEST_RET_MESSAGE(test(n), "CORRECTNESS-ONLY-TEST", 1, 2.25);
+  TIME_RATIO(test(n), test(n2), "", 1, 2.5, 3.75);
+
+
+  report();
+
+  END;
+}
+
@@ -0,0 +1,155 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bst.h"
+
+
+#include "_test.h"
+#include "_tutil.h"
+
+
+
+// char *Desc= "finger insertion test 1";
+
+/**
+ * append_max after lazy removal of the maximum:  builds
+ *   10, 20, .., 10n, removes 10n (left as a dead node) and checks
+ *   that 10n-5 -- below the dead maximum but above every live
+ *   value -- is accepted, that 10n-15 is not, and that 10n comes
+ *   back to life.
+ */
+template <typename Tree>
+int dead_max(Tree & t, int n) {
+  int i;
+  int success = 1;
+
+  t.set_lazy_remove(1.0);   // never compacts by itself
+  for(i=1; i<=n; i++) {
+    if(!t.append_max(10*i))
+      success = 0;
+  }
+  if(!t.remove(10*n) || !t.append_max(10*n-5) || t.append_max(10*n-5) ||
+      (n > 1 && t.append_max(10*n-15)) || !t.append_max(10*n) ||
+      t.append_max(10*n))
+    success = 0;
+  if(t.size() != n+1 || t.num_leq(10*n-5) != n || t.num_leq(10*n) != n+1)
+    success = 0;
+  return success;
+}
+
+/**
+ * func: test
+ * desc: inserts 0..n-1 nearly sorted (i^3:  every key is at most
+ *       3 places from its sorted position) with finger_insert,
+ *       checks the size-balanced height bound, rank queries and
+ *       that duplicates are rejected.  Removes the evens and
+ *       finger-inserts them back in DESCENDING order.
+ *
+ *       Then builds a second tree of 1..n with append_max and
+ *       checks that a key which is not a new maximum is refused.
+ *       Then the nearly sorted and descending finger_inserts again
+ *       on an AVL tree, whose rotations cut the finger.  Last,
+ *       append_max past a lazily removed maximum (see dead_max)
+ *       under the default, AVL and splay policies.
+ *
+ *       Overall runtime should be ~NlogN
+ *
+ */
+int test(int n) {
+  bst<int> t;
+  bst<int> a;
+  bst<int, std::less<int>, false, bst_avl> v;
+  bst<int> d;
+  bst<int, std::less<int>, false, bst_avl> dv;
+  bst<int, std::less<int>, false, bst_splay> ds;
+  int i, x;
+  int success = 1;
+
+  for(i=0; i<n; i++) {
+    if((i^3) < n && !t.finger_insert(i^3))
+      success = 0;
+  }
+  for(i=0; i<n; i++) {
+    if(!t.contains(i))
+      t.finger_insert(i);   // i^3 went past n-1
+  }
+  if(t.size() != n || !sb_height_ok(&t))
+    success = 0;
+  for(i=0; i<n; i++) {
+    if(t.num_leq(i) != i+1 || t.finger_insert(i))
+      success = 0;
+  }
+
+  for(i=0; i<n; i+=2)
+    t.remove(i);
+  for(i=n-1; i>=0; i--) {
+    if(i%2 == 0 && !t.finger_insert(i))
+      success = 0;
+  }
+  for(i=1; i<=n; i++) {
+    if(!t.get_ith(i, x) || x != i-1)
+      success = 0;
+  }
+
+  for(i=1; i<=n; i++) {
+    if(!a.append_max(i))
+      success = 0;
+  }
+  if(a.append_max(n) || a.append_max(1) || a.size() != n ||
+      !sb_height_ok(&a))
+    success = 0;
+  for(i=1; i<=n; i++) {
+    if(a.num_leq(i) != i)
+      success = 0;
+  }
+
+  for(i=0; i<n; i++) {
+    if((i^3) < n && !v.finger_insert(2*(i^3)))
+      success = 0;
+  }
+  for(i=n-1; i>=0; i--) {
+    if(!v.contains(2*i))
+      v.finger_insert(2*i);
+    v.finger_insert(2*i+1);
+  }
+  if(v.size() != 2*n)
+    success = 0;
+  for(i=0; i<2*n; i++) {
+    if(v.num_leq(i) != i+1)
+      success = 0;
+  }
+
+  if(!dead_max(d, n) || !dead_max(dv, n) || !dead_max(ds, n))
+    success = 0;
+  return success;
+}
+
+
+
+
+int main(int argc, char *argv[]) {
+  int n = __N;
+  int n2 = __N2;
+  int ntrials = __NTRIALS;
+
+  if(argc > 1)
+    n = atoi(argv[1]);
+  if(argc > 2)
+    ntrials = atoi(argv[2]);
+
+  set_ntrials(ntrials);
+
+
+
+  START("[finger insertion]: nearly sorted finger_insert, append_max");
+
+  TEST_RET_MESSAGE(baseline(), "COMPILATION", 1, 1.5);
+  TEST_RET_MESSAGE(test(n), "CORRECTNESS-ONLY-TEST", 1, 2.25);
+  TIME_RATIO(test(n), test(n2), "", 1, 2.5, 3.75);
+
+
+  report();
+
+  END;
+}
+
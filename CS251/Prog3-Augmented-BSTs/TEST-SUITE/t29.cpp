@@ -0,0 +1,111 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bst.h"
+
+
+#include "_test.h"
+#include "_tutil.h"
+
+
+
+// char *Desc= "lazy removal test 1";
+
+/* func: test
+ * desc: builds a perfectly balanced BST of height h (values 1..n)
+ *       in lazy-removal mode and removes the evens:  the shape must
+ *       not change (height still h) while contains, the rank
+ *       queries, select_range and min/max ignore the dead nodes.
+ *
+ *       Then:  revives 2 by inserting it, compacts and checks the
+ *              result is size-balanced.
+ *
+ *       Then:  removes everything with compaction triggered at
+ *              25% dead and switches back to eager removal.
+ *
+ *       Runtime:  should be ~nlogn
+ */
+int test(int h, int n) {
+  bst<int> *t = build_balanced(h);
+  std::vector<int> page;
+  int nodd = (n+1)/2;
+  int i, x;
+  int success = 1;
+
+  t->set_lazy_remove(1.0);   // never compacts by itself
+  for(i=2; i<=n; i+=2) {
+    if(!t->remove(i))
+      success = 0;
+  }
+  if(t->height() != h || t->size() != nodd)
+    success = 0;
+  for(i=1; i<=n; i++) {
+    if(t->contains(i) != (i%2 == 1) || t->remove(2*(i/2)+2))
+      success = 0;
+    if(t->num_leq(i) != (i+1)/2)
+      success = 0;
+  }
+  for(i=1; i<=nodd; i++) {
+    if(!t->get_ith(i, x) || x != 2*i-1)
+      success = 0;
+  }
+  t->select_range(1, 3, page);
+  if(page.size() != 3 || page[0] != 1 || page[1] != 3 || page[2] != 5)
+    success = 0;
+  t->remove(1);
+  t->remove(n);
+  if(!t->min(x) || x != 3 || t->max() != n-2)
+    success = 0;
+
+  if(!t->insert(2) || !t->contains(2) || t->num_leq(2) != 1)
+    success = 0;
+  t->compact();
+  if(t->size() != nodd-1 || !sb_height_ok(t) || t->height() >= h)
+    success = 0;
+  if(!t->get_ith(1, x) || x != 2 || !t->get_ith(2, x) || x != 3)
+    success = 0;
+
+  t->set_lazy_remove(0.25);
+  for(i=1; i<=n; i++)
+    t->remove(i);
+  if(t->size() != 0 || t->min(x))
+    success = 0;
+  t->set_lazy_remove(0);
+  if(t->height() != -1)
+    success = 0;
+
+  delete t;
+  return success;
+}
+
+
+
+
+int main(int argc, char *argv[]) {
+  int n = __N;
+  int n2 = __N2;
+  int height = __HEIGHT;
+  int height2 = __HEIGHT2;
+  int ntrials = __NTRIALS;
+
+  if(argc > 1)
+    n = atoi(argv[1]);
+  if(argc > 2)
+    ntrials = atoi(argv[2]);
+
+  set_ntrials(ntrials);
+
+
+
+  START("[lazy removal]: tombstones keep rank queries exact, compact()");
+
+  TEST_RET_MESSAGE(baseline(), "COMPILATION", 1, 1.5);
+  TEST_RET_MESSAGE(test(height, n), "CORRECTNESS-ONLY-TEST", 1, 2.25);
+  TIME_RATIO(test(height, n), test(height2, n2), "", 1, 2.5, 3.75);
+
+
+  report();
+
+  END;
+}
+
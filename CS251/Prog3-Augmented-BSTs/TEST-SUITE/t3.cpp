@@ -12,7 +12,7 @@
 //  char *Desc= "get_ith test 1";
 
 int test(int h, int n) {
-  bst<int> *t = build_balanced(h);
+  test_tree *t = build_balanced(h);
   int success = 1;
   int i;
   int x;
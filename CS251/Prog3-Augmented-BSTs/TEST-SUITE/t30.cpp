@@ -0,0 +1,119 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bst.h"
+#include "bst_buffered.h"
+
+
+#include "_test.h"
+#include "_tutil.h"
+
+
+
+// char *Desc= "buffered bst test 1";
+
+/**
+ * func: test
+ * desc: inserts 1..n in a scattered order (i*k mod n) into a
+ *       bst_buffered with a small buffer, removes the evens, and
+ *       checks contains, size and the rank queries while updates
+ *       are still pending.  Then flushes, checks the height of the
+ *       tree and the queries again.  Last, bst::remove_sorted on its
+ *       own (the flush removes through it):  the multiples of 3 and
+ *       some absent values out of 1..n, under the default policy
+ *       (one merged pass) and AVL (one remove per value).
+ *
+ *       Overall runtime should be ~NlogN
+ *
+ */
+int test(int n) {
+  bst_buffered<int> t(64);
+  bst<int> s;
+  bst<int, std::less<int>, false, bst_avl> a;
+  std::vector<int> outs;
+  int i, x;
+  int k = 7;
+  int success = 1;
+
+  while(n % k == 0)   // i*k mod n must hit every key once
+    k += 2;
+  for(i=0; i<n; i++)
+    t.insert((long long)i * k % n + 1);
+  for(i=2; i<=n; i+=2)
+    t.remove(i);
+  t.insert(2);
+  t.remove(2);
+
+  if(t.pending() == 0 || t.size() != (n+1)/2)
+    success = 0;
+  for(i=1; i<=n; i++) {
+    if(t.contains(i) != (i%2 == 1))
+      success = 0;
+    if(t.num_leq(i) != (i+1)/2 || t.num_geq(i) != (n+1)/2 - i/2)
+      success = 0;
+  }
+  for(i=1; i<=(n+1)/2; i++) {
+    if(!t.get_ith(i, x) || x != 2*i-1)
+      success = 0;
+  }
+
+  t.flush();
+  if(t.pending() != 0 || t.height() > max_sb_height(t.size()))
+    success = 0;
+  for(i=1; i<=n; i++) {
+    if(t.contains(i) != (i%2 == 1) || t.num_leq(i) != (i+1)/2)
+      success = 0;
+  }
+  if(t.num_range(1, n) != (n+1)/2)
+    success = 0;
+
+  for(i=1; i<=n; i++) {
+    s.insert(i);
+    a.insert(i);
+  }
+  outs.push_back(-1);
+  for(i=3; i<=n+3; i+=3)
+    outs.push_back(i);
+  if(s.remove_sorted(outs) != n/3 || a.remove_sorted(outs) != n/3 ||
+      s.remove_sorted(outs) != 0)
+    success = 0;
+  if(s.size() != n - n/3 || a.size() != n - n/3 ||
+      s.height() > max_sb_height(s.size()))
+    success = 0;
+  for(i=1; i<=n; i++) {
+    if(s.contains(i) != (i%3 != 0) || a.contains(i) != (i%3 != 0) ||
+        s.num_leq(i) != i - i/3 || a.num_leq(i) != i - i/3)
+      success = 0;
+  }
+  return success;
+}
+
+
+
+
+int main(int argc, char *argv[]) {
+  int n = __N;
+  int n2 = __N2;
+  int ntrials = __NTRIALS;
+
+  if(argc > 1)
+    n = atoi(argv[1]);
+  if(argc > 2)
+    ntrials = atoi(argv[2]);
+
+  set_ntrials(ntrials);
+
+
+
+  START("[buffered bst]: pending updates, rank queries, flush");
+
+  TEST_RET_MESSAGE(baseline(), "COMPILATION", 1, 1.5);
+  TEST_RET_MESSAGE(test(n), "CORRECTNESS-ONLY-TEST", 1, 2.25);
+  TIME_RATIO(test(n), test(n2), "", 1, 2.5, 3.75);
+
+
+  report();
+
+  END;
+}
+
@@ -0,0 +1,96 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bst.h"
+
+
+#include "_test.h"
+#include "_tutil.h"
+
+
+
+// char *Desc= "lookup cache test 1";
+
+typedef bst<int, std::less<int>, false, bst_size_balanced,
+            bst_lookup_cache<64> > cached_bst;
+
+/**
+ * func: test
+ * desc: builds a tree of the evens 2..2n with a lookup cache and
+ *       repeatedly looks up a small set of hot keys (members and
+ *       non-members), checking that the cache answers them and that
+ *       every contains() is counted as a hit or a miss.  Then
+ *       inserts/removes hot keys and checks the answers change
+ *       (the cache is invalidated).
+ *
+ *       Overall runtime should be ~NlogN
+ *
+ */
+int test(int n) {
+  cached_bst t;
+  unsigned long calls = 0;
+  int i, r, x;
+  int success = 1;
+
+  for(i=1; i<=n; i++)
+    t.insert(2*i);
+
+  for(r=0; r<8; r++) {
+    for(i=1; i<=n; i++) {
+      x = i % 16 + 1;          // hot:  1..16
+      if(t.contains(x) != (x%2 == 0))
+        success = 0;
+      calls++;
+    }
+  }
+  if(t.lookup_hits() + t.lookup_misses() != calls)
+    success = 0;
+  if(t.lookup_hits() < calls / 2)
+    success = 0;
+
+  for(x=1; x<=16; x++) {
+    if(x%2 == 0)
+      t.remove(x);
+    else
+      t.insert(x);
+  }
+  for(x=1; x<=16; x++) {
+    if(t.contains(x) != (x%2 == 1) || t.contains(x) != (x%2 == 1))
+      success = 0;
+  }
+  for(i=1; i<=n; i++) {
+    x = 2*i;
+    if(t.contains(x) != (x > 16))
+      success = 0;
+  }
+  return success;
+}
+
+
+
+
+int main(int argc, char *argv[]) {
+  int n = __N;
+  int n2 = __N2;
+  int ntrials = __NTRIALS;
+
+  if(argc > 1)
+    n = atoi(argv[1]);
+  if(argc > 2)
+    ntrials = atoi(argv[2]);
+
+  set_ntrials(ntrials);
+
+
+
+  START("[lookup cache]: hot keys, hit/miss counts, invalidation");
+
+  TEST_RET_MESSAGE(baseline(), "COMPILATION", 1, 1.5);
+  TEST_RET_MESSAGE(test(n), "CORRECTNESS-ONLY-TEST", 1, 2.25);
+  TIME_RATIO(test(n), test(n2), "", 1, 2.5, 3.75);
+
+
+  report();
+
+  END;
+}
@@ -0,0 +1,154 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <string>
+#include "bst.h"
+
+
+#include "_test.h"
+#include "_tutil.h"
+
+
+
+// char *Desc= "bloom filter test 1";
+
+typedef bst<int, std::less<int>, false, bst_size_balanced,
+            bst_bloom_filter<10> > filtered_bst;
+
+// case-insensitive ordering of strings, and a hash consistent with it
+//   (bst_bloom_filter<10> alone would not compile with nocase_less)
+struct nocase_less {
+  bool operator()(const std::string & a, const std::string & b) const {
+    size_t i;
+
+    for(i=0; i<a.size() && i<b.size(); i++) {
+      if(tolower(a[i]) != tolower(b[i]))
+        return tolower(a[i]) < tolower(b[i]);
+    }
+    return a.size() < b.size();
+  }
+};
+
+struct nocase_hash {
+  size_t operator()(const std::string & s) const {
+    size_t h = 14695981039346656037ULL;
+    size_t i;
+
+    for(i=0; i<s.size(); i++)
+      h = (h ^ (unsigned char)tolower(s[i])) * 1099511628211ULL;
+    return h;
+  }
+};
+
+typedef bst<std::string, nocase_less, false, bst_size_balanced,
+            bst_bloom_filter<10, nocase_hash> > nocase_bst;
+
+// keys that differ from the inserted ones only in case are present
+static int nocase_ok() {
+  nocase_bst t;
+  int i;
+
+  for(i=0; i<200; i++)
+    t.insert("Key" + std::to_string(i));
+  for(i=0; i<400; i++) {
+    if(t.contains("kEY" + std::to_string(i)) != (i < 200))
+      return 0;
+  }
+  return t.lookup_hits() > 0;
+}
+
+/**
+ * func: test
+ * desc: builds a tree of the evens 2..2n with a Bloom filter and
+ *       looks up 1..2n:  the answers must be exact and most of the
+ *       (odd) absent keys must be answered by the filter.  Then
+ *       removes the multiples of 4 and inserts the odds (forcing
+ *       rebuilds of the filter) and checks the answers again.
+ *       Removes of absent keys must not count as stale entries:
+ *       after n of them the filter must not be rebuilt (and
+ *       resized) when the tree then grows within its capacity.
+ *       Also checks a filter over a case-insensitive comparator.
+ *
+ *       Overall runtime should be ~NlogN
+ *
+ */
+int test(int n) {
+  filtered_bst t;
+  unsigned long calls = 0;
+  int i;
+  int success = 1;
+
+  for(i=1; i<=n; i++)
+    t.insert(2*i);
+
+  for(i=1; i<=2*n; i++) {
+    if(t.contains(i) != (i%2 == 0))
+      success = 0;
+    calls++;
+  }
+  if(t.lookup_hits() + t.lookup_misses() != calls)
+    success = 0;
+  if(t.lookup_hits() < (unsigned long)n * 9 / 10)
+    success = 0;
+
+  for(i=4; i<=2*n; i+=4)
+    t.remove(i);
+  for(i=1; i<=2*n; i+=2)
+    t.insert(i);
+  for(i=1; i<=2*n; i++) {
+    if(t.contains(i) != (i%4 != 0))
+      success = 0;
+  }
+  if(t.contains(0) || t.contains(2*n+1))
+    success = 0;
+
+  filtered_bst f;
+  size_t bytes;
+
+  for(i=1; i<=n; i++)
+    f.insert(2*i);
+  f.contains(1);               // builds the filter, sized for 2n keys
+  for(i=1; i<=n; i++) {
+    if(f.remove(2*i-1))
+      success = 0;
+  }
+  bytes = f.memory_usage().other_bytes;
+  for(i=n+1; i<2*n; i++)
+    f.insert(2*i);             // still fit in the filter
+  if(f.contains(1) || !f.contains(4*n-2) ||
+      f.memory_usage().other_bytes != bytes)
+    success = 0;
+  if(!nocase_ok())
+    success = 0;
+  return success;
+}
+
+
+
+
+int main(int argc, char *argv[]) {
+  int n = __N;
+  int n2 = __N2;
+  int ntrials = __NTRIALS;
+
+  if(argc > 1)
+    n = atoi(argv[1]);
+  if(argc > 2)
+    ntrials = atoi(argv[2]);
+
+  set_ntrials(ntrials);
+
+
+
+  START("[bloom filter]: absent keys, hit/miss counts, rebuilds");
+
+  TEST_RET_MESSAGE(baseline(), "COMPILATION", 1, 1.5);
+  TEST_RET_MESSAGE(test(n), "CORRECTNESS-ONLY-TEST", 1, 2.25);
+  TIME_RATIO(test(n), test(n2), "", 1, 2.5, 3.75);
+
+
+  report();
+
+  END;
+}
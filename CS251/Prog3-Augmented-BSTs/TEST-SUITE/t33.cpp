@@ -0,0 +1,106 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "bst.h"
+
+
+#include "_test.h"
+#include "_tutil.h"
+
+
+
+// char *Desc= "visitor test 1";
+
+/**
+ * func: test
+ * desc: builds the perfectly balanced tree over 1..2^(h+1)-1 and
+ *       checks the exact order of all four visitors on it, then
+ *       that a visitor returning false stops after that call.
+ *
+ *       Overall runtime should be ~NlogN (building the tree;  the
+ *       visitors are linear)
+ *
+ */
+int test(int h) {
+  bst<int> *t = build_balanced(h);
+  int n = 2*two_to_x(h) - 1;
+  int count, d, k;
+  std::vector<int> v, expect;
+  int success = 1;
+
+  // inorder:  1..n
+  t->visit_inorder([&](const int &x){ v.push_back(x); return true; });
+  for(k=1; k<=n; k++)
+    expect.push_back(k);
+  if(v != expect)
+    success = 0;
+
+  // level order:  level d holds the odd multiples of 2^(h-d)
+  v.clear();
+  expect.clear();
+  t->visit_level_order([&](const int &x){ v.push_back(x); return true; });
+  for(d=0; d<=h; d++) {
+    for(k=1; k<two_to_x(d+1); k+=2)
+      expect.push_back(k * two_to_x(h-d));
+  }
+  if(v != expect)
+    success = 0;
+
+  // preorder starts at the root and is followed by its left
+  //   subtree (1..n/2 in some order);  postorder ends at the root
+  v.clear();
+  t->visit_preorder([&](const int &x){ v.push_back(x); return true; });
+  if((int)v.size() != n || v[0] != (n+1)/2 || (n > 1 && v[1] != (n+1)/4))
+    success = 0;
+  for(k=1; k<=n/2; k++) {
+    if(v[k] > n/2)
+      success = 0;
+  }
+  v.clear();
+  t->visit_postorder([&](const int &x){ v.push_back(x); return true; });
+  if((int)v.size() != n || v[n-1] != (n+1)/2 || v[0] != 1)
+    success = 0;
+
+  // early exit
+  count = 0;
+  if(t->visit_inorder([&](const int &){ return ++count < n/2; }) ||
+      count != n/2)
+    success = 0;
+  count = 0;
+  if(t->visit_level_order([&](const int &){ return ++count < 3; }) ||
+      count != 3)
+    success = 0;
+
+  bst_free(t);
+  return success;
+}
+
+
+
+
+int main(int argc, char *argv[]) {
+  int height = __HEIGHT;
+  int height2 = __HEIGHT2;
+  int ntrials = __NTRIALS;
+
+  if(argc > 1)
+    height = atoi(argv[1]);
+  if(argc > 2)
+    ntrials = atoi(argv[2]);
+
+  set_ntrials(ntrials);
+
+
+
+  START("[visitors]: inorder, preorder, postorder, level order, early exit");
+
+  TEST_RET_MESSAGE(baseline(), "COMPILATION", 1, 1.5);
+  TEST_RET_MESSAGE(test(height), "CORRECTNESS-ONLY-TEST", 1, 2.25);
+  TIME_RATIO(test(height), test(height2), "", 1, 2.5, 3.75);
+
+
+  report();
+
+  END;
+}
@@ -0,0 +1,134 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "bst.h"
+
+
+#include "_test.h"
+#include "_tutil.h"
+
+
+
+// char *Desc= "dump test 1";
+
+// compact form of the perfectly balanced tree over lo..hi
+static void expect_compact(int lo, int hi, std::string &out) {
+  int m = (lo + hi) / 2;
+
+  if(lo > hi)
+    return;
+  out += std::to_string(m);
+  if(lo == hi)
+    return;
+  out += '(';
+  expect_compact(lo, m-1, out);
+  out += ',';
+  expect_compact(m+1, hi, out);
+  out += ')';
+}
+
+// character values print as characters, not as their codes:
+//   dump, inorder() and preorder() of the tree b(a,c)
+static int chars_ok() {
+  bst<char> t;
+  std::ostringstream compact, text;
+  std::streambuf *saved;
+  std::string s;
+
+  t.insert('b');
+  t.insert('a');
+  t.insert('c');
+  {
+    bst_writer w(compact);
+    t.dump(w, true);
+  }
+  saved = std::cout.rdbuf(text.rdbuf());
+  t.inorder();
+  t.preorder();
+  std::cout.rdbuf(saved);
+  s = text.str();
+
+  return compact.str() == "b(a,c)\n" &&
+         s.find("[ a ]\n[ b ]\n[ c ]\n") != std::string::npos &&
+         s.find("97") == std::string::npos;
+}
+
+/**
+ * func: test
+ * desc: dumps the perfectly balanced tree over 1..2^(h+1)-1 through
+ *       a bst_writer with a small buffer, in compact form (checked
+ *       against the expected string) and indented (checked line
+ *       count, first line and indentation of the deepest nodes).
+ *       Also checks that a bst<char> prints characters, not codes.
+ *
+ *       Overall runtime should be ~NlogN (building the tree)
+ *
+ */
+int test(int h) {
+  bst<int> *t = build_balanced(h);
+  int n = 2*two_to_x(h) - 1;
+  std::ostringstream compact, indented;
+  std::string expect, line;
+  int lines = 0, deepest = 0;
+  int success = 1;
+
+  {
+    bst_writer w(compact, 100);
+    t->dump(w, true);
+  }
+  expect_compact(1, n, expect);
+  if(compact.str() != expect + "\n")
+    success = 0;
+
+  {
+    bst_writer w(indented, 100);
+    t->dump(w);
+  }
+  std::istringstream in(indented.str());
+  while(std::getline(in, line)) {
+    if(lines == 0 && line != "[ " + std::to_string((n+1)/2) + " ]")
+      success = 0;
+    if(line == std::string(3*(h+1), '-') + " nullptr ")
+      deepest++;
+    lines++;
+  }
+  if(lines != 2*n+1 || deepest != n+1)
+    success = 0;
+  if(!chars_ok())
+    success = 0;
+
+  bst_free(t);
+  return success;
+}
+
+
+
+
+int main(int argc, char *argv[]) {
+  int height = __HEIGHT;
+  int height2 = __HEIGHT2;
+  int ntrials = __NTRIALS;
+
+  if(argc > 1)
+    height = atoi(argv[1]);
+  if(argc > 2)
+    ntrials = atoi(argv[2]);
+
+  set_ntrials(ntrials);
+
+
+
+  START("[dump]: bst_writer, compact and indented formats");
+
+  TEST_RET_MESSAGE(baseline(), "COMPILATION", 1, 1.5);
+  TEST_RET_MESSAGE(test(height), "CORRECTNESS-ONLY-TEST", 1, 2.25);
+  TIME_RATIO(test(height), test(height2), "", 1, 2.5, 3.75);
+
+
+  report();
+
+  END;
+}
@@ -0,0 +1,142 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#define BST_METRICS
+#include "bst.h"
+
+
+#include "_test.h"
+#include "_tutil.h"
+
+
+
+// char *Desc= "metrics test 1";
+
+/**
+ * func: test
+ * desc: with BST_METRICS defined, inserts 1..n in order, looks up
+ *       1..2n and removes the evens, checking the counters charged
+ *       to each kind of operation:  calls, allocations and frees
+ *       exactly, comparisons and rebuilds/rotations loosely.
+ *       A set_intersection must be one OTHER call on its first
+ *       tree, not add to the counters of that tree's last
+ *       operation.  Then checks that reset_metrics() zeroes them,
+ *       and that
+ *       with lazy removal only a direct compact() counts as a REMOVE
+ *       call (the compactions inside remove and set_lazy_remove do
+ *       not).
+ *
+ *       Overall runtime should be ~NlogN
+ *
+ */
+int test(int n) {
+  bst<int> t;
+  bst<int, std::less<int>, false, bst_avl> a;
+  bst<int, std::less<int>, false, bst_avl> *u;
+  bst_metrics m;
+  int i, x;
+  int success = 1;
+
+  for(i=1; i<=n; i++) {
+    t.insert(i);
+    a.insert(i);
+  }
+  for(i=1; i<=2*n; i++)
+    t.contains(i);
+  for(i=2; i<=n; i+=2)
+    t.remove(i);
+  t.get_ith(1, x);
+  t.num_range(1, n);
+
+  m = t.metrics();
+  if(m.ops[bst_metrics::INSERT].calls != (unsigned long long)n ||
+      m.ops[bst_metrics::INSERT].allocs != (unsigned long long)n ||
+      m.ops[bst_metrics::INSERT].rebuilds == 0 ||
+      m.ops[bst_metrics::INSERT].rebuilt_nodes <
+        m.ops[bst_metrics::INSERT].rebuilds)
+    success = 0;
+  if(m.ops[bst_metrics::LOOKUP].calls != (unsigned long long)(2*n) ||
+      m.ops[bst_metrics::LOOKUP].comparisons >
+        (unsigned long long)(2*n) * (max_sb_height(n) + 1) ||
+      m.ops[bst_metrics::LOOKUP].allocs != 0)
+    success = 0;
+  if(m.ops[bst_metrics::REMOVE].calls != (unsigned long long)(n/2) ||
+      m.ops[bst_metrics::REMOVE].frees != (unsigned long long)(n/2))
+    success = 0;
+  if(m.ops[bst_metrics::QUERY].calls != 2 ||
+      m.ops[bst_metrics::QUERY].visits == 0)
+    success = 0;
+  if(m.total().calls != (unsigned long long)(n + 2*n + n/2 + 2))
+    success = 0;
+
+  m = a.metrics();
+  if(m.ops[bst_metrics::INSERT].rotations == 0 ||
+      m.ops[bst_metrics::INSERT].rebuilds != 0)
+    success = 0;
+
+  a.contains(1);
+  m = a.metrics();
+  u = a.set_intersection(a, a);
+  if(a.metrics().ops[bst_metrics::LOOKUP].comparisons !=
+        m.ops[bst_metrics::LOOKUP].comparisons ||
+      a.metrics().ops[bst_metrics::OTHER].calls != 1 ||
+      a.metrics().ops[bst_metrics::OTHER].comparisons !=
+        (unsigned long long)n ||
+      u->size() != n)
+    success = 0;
+  delete u;
+
+  t.reset_metrics();
+  if(t.metrics().total().calls != 0 || t.metrics().total().comparisons != 0)
+    success = 0;
+
+  // lazy:  n/4 dead nodes trigger compactions inside remove()
+  t.set_lazy_remove(0.25);
+  for(i=1; i<=n; i+=2)
+    t.remove(i);
+  m = t.metrics();
+  if(m.ops[bst_metrics::REMOVE].calls != (unsigned long long)((n+1)/2) ||
+      m.ops[bst_metrics::REMOVE].rebuilds == 0)
+    success = 0;
+  for(i=1; i<=4; i++)
+    t.insert(i);
+  t.remove(1);
+  t.compact();
+  t.remove(2);
+  t.set_lazy_remove(0);
+  m = t.metrics();
+  if(m.ops[bst_metrics::REMOVE].calls != (unsigned long long)((n+1)/2 + 3) ||
+      m.ops[bst_metrics::REMOVE].frees != (unsigned long long)((n+1)/2 + 2) ||
+      t.size() != 2)
+    success = 0;
+  return success;
+}
+
+
+
+
+int main(int argc, char *argv[]) {
+  int n = __N;
+  int n2 = __N2;
+  int ntrials = __NTRIALS;
+
+  if(argc > 1)
+    n = atoi(argv[1]);
+  if(argc > 2)
+    ntrials = atoi(argv[2]);
+
+  set_ntrials(ntrials);
+
+
+
+  START("[metrics]: BST_METRICS operation counters");
+
+  TEST_RET_MESSAGE(baseline(), "COMPILATION", 1, 1.5);
+  TEST_RET_MESSAGE(test(n), "CORRECTNESS-ONLY-TEST", 1, 2.25);
+  TIME_RATIO(test(n), test(n2), "", 1, 2.5, 3.75);
+
+
+  report();
+
+  END;
+}
@@ -0,0 +1,115 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bst.h"
+
+
+#include "_test.h"
+#include "_tutil.h"
+
+
+
+// char *Desc= "prefetch test 1";
+
+typedef bst<int, std::less<int>, false, bst_size_balanced,
+            bst_prefetch> prefetch_bst;
+
+typedef bst<int, std::less<int>, true, bst_avl,
+            bst_prefetch> prefetch_avl_multiset;
+
+// prefetching composed with a Bloom filter and with a cache
+typedef bst<int, std::less<int>, false, bst_size_balanced,
+            bst_prefetch_with<bst_bloom_filter<10> > > prefetch_filtered;
+
+typedef bst<int, std::less<int>, false, bst_avl,
+            bst_prefetch_with<bst_lookup_cache<64> > > prefetch_cached;
+
+/**
+ * func: test
+ * desc: inserts 1..n in a scattered order (i*k mod n) into trees
+ *       using the prefetching descents (a size-balanced set and an
+ *       AVL multiset), removes the evens and checks contains,
+ *       size and height.  Then the same keys with prefetching
+ *       composed with a Bloom filter and with a cache:  the answers
+ *       must be exact and the filter / cache must report hits.
+ *
+ *       Overall runtime should be ~NlogN
+ *
+ */
+int test(int n) {
+  prefetch_bst t;
+  prefetch_avl_multiset m;
+  prefetch_filtered f;
+  prefetch_cached c;
+  int i, x;
+  int k = 7;
+  int success = 1;
+
+  while(n % k == 0)   // i*k mod n must hit every key once
+    k += 2;
+  for(i=0; i<n; i++) {
+    x = (long long)i * k % n + 1;
+    if(!t.insert(x) || t.insert(x))
+      success = 0;
+    m.insert(x);
+    m.insert(x);
+    f.insert(2*x);
+    c.insert(x);
+  }
+  for(i=2; i<=n; i+=2) {
+    t.remove(i);
+    m.remove(i);
+  }
+  if(t.size() != (n+1)/2 || m.size() != n + (n+1)/2)
+    success = 0;
+  for(i=0; i<=n+1; i++) {
+    if(t.contains(i) != (i >= 1 && i <= n && i%2 == 1))
+      success = 0;
+    if(m.contains(i) != (i >= 1 && i <= n))
+      success = 0;
+  }
+  if(t.height() > max_sb_height(t.size()) || t.lookup_hits() != 0)
+    success = 0;
+
+  for(i=0; i<=2*n+1; i++) {
+    if(f.contains(i) != (i >= 2 && i <= 2*n && i%2 == 0))
+      success = 0;
+  }
+  for(i=1; i<=n; i++) {
+    if(!c.contains(1) || c.contains(n+1))
+      success = 0;
+  }
+  if(f.lookup_hits() < (unsigned long)n * 9 / 10 ||
+      c.lookup_hits() < 2*(unsigned long)(n-1) || c.size() != n)
+    success = 0;
+  return success;
+}
+
+
+
+
+int main(int argc, char *argv[]) {
+  int n = __N;
+  int n2 = __N2;
+  int ntrials = __NTRIALS;
+
+  if(argc > 1)
+    n = atoi(argv[1]);
+  if(argc > 2)
+    ntrials = atoi(argv[2]);
+
+  set_ntrials(ntrials);
+
+
+
+  START("[prefetch]: prefetching descents in contains/insert");
+
+  TEST_RET_MESSAGE(baseline(), "COMPILATION", 1, 1.5);
+  TEST_RET_MESSAGE(test(n), "CORRECTNESS-ONLY-TEST", 1, 2.25);
+  TIME_RATIO(test(n), test(n2), "", 1, 2.5, 3.75);
+
+
+  report();
+
+  END;
+}
@@ -0,0 +1,99 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bst.h"
+
+
+#include "_test.h"
+#include "_tutil.h"
+
+
+
+// char *Desc= "memory usage test 1";
+
+/**
+ * func: test
+ * desc: inserts 1..n, removes the evens (eagerly) and checks the
+ *       node, slot and byte counts of memory_usage() against each
+ *       other;  then reinserts the evens (reusing the freed slots)
+ *       and checks that nothing new was reserved.  Finally checks
+ *       a copy (one block, no holes) and a tree with tombstones.
+ *
+ *       Overall runtime should be ~NlogN
+ *
+ */
+int test(int n) {
+  bst<int> t;
+  bst_memory m, before;
+  int i;
+  int success = 1;
+
+  m = t.memory_usage();
+  if(m.nodes != 0 || m.reserved_bytes != 0 || m.other_bytes < sizeof t)
+    success = 0;
+
+  for(i=1; i<=n; i++)
+    t.insert(i);
+  for(i=2; i<=n; i+=2)
+    t.remove(i);
+
+  m = t.memory_usage();
+  if(m.nodes != (size_t)(n+1)/2 || m.free_slots != (size_t)n/2 ||
+      m.used_bytes != m.nodes * m.node_bytes || m.blocks == 0 ||
+      m.reserved_bytes < (m.nodes + m.free_slots + m.unused_slots) *
+        m.node_bytes)
+    success = 0;
+  if(n > 1 && (m.fragmentation <= 0.4 || m.fragmentation >= 0.6))
+    success = 0;
+
+  before = m;
+  for(i=2; i<=n; i+=2)
+    t.insert(i);
+  m = t.memory_usage();
+  if(m.nodes != (size_t)n || m.free_slots != 0 || m.fragmentation != 0.0 ||
+      m.reserved_bytes != before.reserved_bytes)
+    success = 0;
+
+  bst<int> c(t);
+  m = c.memory_usage();
+  if(m.nodes != (size_t)n || m.blocks != 1 || m.unused_slots != 0 ||
+      m.free_slots != 0)
+    success = 0;
+
+  c.set_lazy_remove(1.0);
+  for(i=1; i<=n; i+=2)
+    c.remove(i);
+  m = c.memory_usage();
+  if(m.nodes != (size_t)n || m.dead_nodes != (size_t)(n+1)/2)
+    success = 0;
+  return success;
+}
+
+
+
+
+int main(int argc, char *argv[]) {
+  int n = __N;
+  int n2 = __N2;
+  int ntrials = __NTRIALS;
+
+  if(argc > 1)
+    n = atoi(argv[1]);
+  if(argc > 2)
+    ntrials = atoi(argv[2]);
+
+  set_ntrials(ntrials);
+
+
+
+  START("[memory_usage]: nodes, slots, reserved bytes, fragmentation");
+
+  TEST_RET_MESSAGE(baseline(), "COMPILATION", 1, 1.5);
+  TEST_RET_MESSAGE(test(n), "CORRECTNESS-ONLY-TEST", 1, 2.25);
+  TIME_RATIO(test(n), test(n2), "", 1, 2.5, 3.75);
+
+
+  report();
+
+  END;
+}
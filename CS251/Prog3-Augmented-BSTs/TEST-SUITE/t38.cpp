@@ -0,0 +1,175 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <set>
+#include <string>
+#include <vector>
+#include "bst_strings.h"
+
+
+#include "_test.h"
+#include "_tutil.h"
+
+
+
+// char *Desc= "interned string keys test 1";
+
+static std::string url(int i){
+  char buf[64];
+
+  sprintf(buf, "https://www.example.com/catalog/item/%07d", i);
+  return std::string(buf);
+}
+
+/**
+ * func: test
+ * desc: inserts n URLs (long shared prefix) in scattered order, each
+ *       twice, into a bst_string_set and a std::set;  checks dedup,
+ *       the arena size, get_ith/num_leq/num_geq/num_range/contains
+ *       (present and absent keys), then removes every third key and
+ *       checks a frozen snapshot against the set and that it takes
+ *       fewer bytes than the arena.  A second set shares the arena.
+ *       Then a set with a lookup cache is queried with temporaries
+ *       and with a string rewritten between two lookups.  Last,
+ *       the empty string as the first key of a fresh set and as the
+ *       only string of a snapshot.
+ *
+ *       Overall runtime should be ~NlogN
+ *
+ */
+int test(int n) {
+  bst_string_arena shared;
+  bst_string_set<> s;
+  bst_string_set<> s2(&shared);
+  std::set<std::string> ref;
+  std::vector<int> order;
+  std::string x;
+  size_t total = 0;
+  unsigned r = 12345;
+  int i, j;
+  int success = 1;
+
+  for(i=0; i<n; i++)
+    order.push_back(2*i + 1);
+  for(i=n-1; i>0; i--){
+    r = r * 1103515245u + 12345u;
+    j = (r >> 8) % (i + 1);
+    std::swap(order[i], order[j]);
+  }
+
+  for(i=0; i<n; i++){
+    x = url(order[i]);
+    if(!s.insert(x) || s.insert(x) || !s2.insert(x))
+      success = 0;
+    ref.insert(x);
+    total += x.size();
+  }
+  if(s.size() != n || s.strings().bytes_used() != total ||
+      shared.bytes_used() != total)
+    success = 0;
+
+  // odd numbers are present, even ones (and the ends) are not
+  for(i=0; i<=2*n; i++){
+    x = url(i);
+    if(s.contains(x) != (i % 2 == 1))
+      success = 0;
+    if(s.num_leq(x) != (i+1) / 2 || s.num_geq(x) != n - i/2)
+      success = 0;
+  }
+  if(s.num_range(url(3), url(2*n)) != n - 1 ||
+      s.num_range(url(4), url(2)) != 0)
+    success = 0;
+  if(s.num_leq("") != 0 || s.num_leq("https://www.example.com/catalog/") != 0 ||
+      s.num_geq("z") != 0)
+    success = 0;
+
+  for(i=0; i<n; i+=3){
+    x = url(order[i]);
+    if(!s.remove(x) || s.remove(x))
+      success = 0;
+    ref.erase(x);
+  }
+  if(s.size() != (int)ref.size() || s2.size() != n)
+    success = 0;
+
+  i = 1;
+  for(std::set<std::string>::iterator it = ref.begin(); it != ref.end(); ++it){
+    if(!s.get_ith(i, x) || x != *it)
+      success = 0;
+    i++;
+  }
+
+  bst_frozen_strings f = s.freeze();
+
+  if(f.size() != (int)ref.size() || f.memory_bytes() >= total)
+    success = 0;
+  i = 1;
+  for(std::set<std::string>::iterator it = ref.begin(); it != ref.end(); ++it){
+    if(!f.get_ith(i, x) || x != *it || !f.contains(*it) ||
+        f.num_leq(*it) != i)
+      success = 0;
+    i++;
+  }
+  for(i=0; i<=2*n; i+=2){
+    x = url(i);
+    if(f.contains(x) || f.num_leq(x) != s.num_leq(x))
+      success = 0;
+  }
+  if(f.get_ith(0, x) || f.get_ith(f.size() + 1, x))
+    success = 0;
+
+  // a lookup cache must not keep pointers into the caller's string:
+  //   q is looked up (absent), then rewritten in place to a member
+  //   and looked up again.
+  bst_string_set<bst_size_balanced, bst_lookup_cache<4> > c;
+  std::string q = url(2);
+
+  for(i=0; i<n; i++)
+    c.insert(url(order[i]));
+  if(c.contains(q) || c.contains(std::string(url(4))))
+    success = 0;
+  q.replace(q.size() - 1, 1, "1");
+  if(!c.contains(q) || c.contains(std::string(url(4))) ||
+      !c.contains(std::string(url(1))))
+    success = 0;
+
+  bst_string_set<> e;
+
+  if(!e.insert("") || e.insert("") || !e.contains("") || e.size() != 1 ||
+      e.strings().bytes_used() != 0)
+    success = 0;
+  bst_frozen_strings fe = e.freeze();
+  if(!fe.contains("") || fe.contains("a") || fe.num_leq("") != 1 ||
+      !fe.get_ith(1, x) || x != "")
+    success = 0;
+  return success;
+}
+
+
+
+
+int main(int argc, char *argv[]) {
+  int n = __N;
+  int n2 = __N2;
+  int ntrials = __NTRIALS;
+
+  if(argc > 1)
+    n = atoi(argv[1]);
+  if(argc > 2)
+    ntrials = atoi(argv[2]);
+
+  set_ntrials(ntrials);
+
+
+
+  START("[bst_string_set]: interned keys, prefix compares, frozen snapshot");
+
+  TEST_RET_MESSAGE(baseline(), "COMPILATION", 1, 1.5);
+  TEST_RET_MESSAGE(test(n), "CORRECTNESS-ONLY-TEST", 1, 2.25);
+  TIME_RATIO(test(n), test(n2), "", 1, 2.5, 3.75);
+
+
+  report();
+
+  END;
+}
@@ -0,0 +1,155 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "bst.h"
+#include "bst_int.h"
+
+
+#include "_test.h"
+#include "_tutil.h"
+
+
+
+// char *Desc= "B+-tree integer set test 1";
+
+// does s hold the same elements as t (all keys below 2n+1)?
+static int same(bst_int_set<int> & s, bst<int> & t, int n) {
+  int i, x, y;
+
+  if(s.size() != t.size())
+    return 0;
+  for(i=0; i<=2*n; i++){
+    if(s.contains(i) != t.contains(i) || s.num_leq(i) != t.num_leq(i) ||
+        s.num_geq(i) != t.num_geq(i) ||
+        s.num_range(i, i + 7) != t.num_range(i, i + 7))
+      return 0;
+  }
+  for(i=1; i<=t.size(); i++){
+    if(!s.get_ith(i, x) || !t.get_ith(i, y) || x != y)
+      return 0;
+  }
+  if(s.get_ith(0, x) || s.get_ith(s.size() + 1, x) ||
+      s.num_range(5, 4) != 0)
+    return 0;
+  return 1;
+}
+
+/**
+ * func: test
+ * desc: inserts the odd numbers below 2n in scattered order into a
+ *       bst_int_set and a bst<int>, then checks contains, num_leq,
+ *       num_geq and num_range for every key in 0..2n (present or
+ *       not) and get_ith for every rank against the bst.  Removes
+ *       every third key from both and checks again, then checks
+ *       to_vector, a copy, a move and from_sorted_vec.
+ *       Last, inserts 1..n in ascending and in descending order:
+ *       the nodes must come out full, i.e. as high as
+ *       from_sorted_vec builds them, and stay consistent while
+ *       the upper half is removed from the top down.
+ *
+ *       Overall runtime should be ~NlogN
+ *
+ */
+int test(int n) {
+  bst_int_set<int> s;
+  bst<int> t;
+  std::vector<int> order;
+  std::vector<int> *v;
+  unsigned r = 251;
+  int i, j, x;
+  int success = 1;
+
+  for(i=0; i<n; i++)
+    order.push_back(2*i + 1);
+  for(i=n-1; i>0; i--){
+    r = r * 1103515245u + 12345u;
+    j = (r >> 8) % (i + 1);
+    std::swap(order[i], order[j]);
+  }
+
+  for(i=0; i<n; i++){
+    if(!s.insert(order[i]) || s.insert(order[i]))
+      success = 0;
+    t.insert(order[i]);
+  }
+  if(!same(s, t, n) || (n > 0 && (!s.min(x) || x != 1 || s.max() != 2*n-1)))
+    success = 0;
+
+  for(i=0; i<n; i+=3){
+    if(!s.remove(order[i]) || s.remove(order[i]))
+      success = 0;
+    t.remove(order[i]);
+  }
+  if(!same(s, t, n))
+    success = 0;
+
+  v = s.to_vector();
+  bst_int_set<int> c(s);
+  bst_int_set<int> *f = bst_int_set<int>::from_sorted_vec(*v, v->size());
+  for(i=0; i<(int)v->size(); i++){
+    if(!t.get_ith(i+1, x) || (*v)[i] != x)
+      success = 0;
+  }
+  bst_int_set<int> m(std::move(c));
+  if(!same(m, t, n) || c.size() != 0 || c.contains(1) || !same(*f, t, n))
+    success = 0;
+  c = std::move(m);
+  if(!same(c, t, n) || m.size() != 0)
+    success = 0;
+  delete v;
+  delete f;
+
+  bst_int_set<int> up, down;
+  std::vector<int> sorted;
+
+  for(i=1; i<=n; i++){
+    up.insert(i);
+    down.insert(n + 1 - i);
+    sorted.push_back(i);
+  }
+  f = bst_int_set<int>::from_sorted_vec(sorted, n);
+  if(up.height() != f->height() || down.height() != f->height())
+    success = 0;
+  for(i=n; i>n/2; i--){
+    if(!up.remove(i) || !down.remove(i))
+      success = 0;
+  }
+  for(i=1; i<=n; i++){
+    if(up.contains(i) != (i <= n/2) || down.num_leq(i) != (i <= n/2 ? i : n/2))
+      success = 0;
+  }
+  if(up.size() != n/2 || (n/2 > 0 && (!down.get_ith(n/2, x) || x != n/2)))
+    success = 0;
+  delete f;
+  return success;
+}
+
+
+
+
+int main(int argc, char *argv[]) {
+  int n = __N;
+  int n2 = __N2;
+  int ntrials = __NTRIALS;
+
+  if(argc > 1)
+    n = atoi(argv[1]);
+  if(argc > 2)
+    ntrials = atoi(argv[2]);
+
+  set_ntrials(ntrials);
+
+
+
+  START("[bst_int_set]: B+-tree set, rank queries vs. bst");
+
+  TEST_RET_MESSAGE(baseline(), "COMPILATION", 1, 1.5);
+  TEST_RET_MESSAGE(test(n), "CORRECTNESS-ONLY-TEST", 1, 2.25);
+  TIME_RATIO(test(n), test(n2), "", 1, 2.5, 3.75);
+
+
+  report();
+
+  END;
+}
@@ -14,7 +14,7 @@
 // char *Desc= "bst_get_ith test2";
 
 int test(int h, int n) {
-  bst<int> *t = build_balanced_rem_evens(h);
+  test_tree *t = build_balanced_rem_evens(h);
   int success = 1;
   int i, tgt;
   int x;
@@ -0,0 +1,115 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "bst.h"
+
+
+#include "_test.h"
+#include "_tutil.h"
+
+
+
+// char *Desc= "parallel bulk build test 1";
+
+// perfectly balanced:  height floor(lg n)
+static int balanced_height(int n) {
+  int h = -1;
+
+  while(n > 0){
+    h++;
+    n /= 2;
+  }
+  return h;
+}
+
+/**
+ * func: test
+ * desc: builds trees with from_unsorted from n scattered values in
+ *       0..n/2 (so most appear twice) on 1 and on 4 threads, as a
+ *       set and as a multiset, and checks them against trees built
+ *       by insert:  size, every rank (get_ith), num_leq of every
+ *       key, perfect balance;  then updates one and checks that the
+ *       arena slots behave like any other nodes.
+ *
+ *       Overall runtime should be ~NlogN
+ *
+ */
+int test(int n) {
+  std::vector<int> vals;
+  bst<int> ref;
+  bst<int, std::less<int>, true> mref;
+  unsigned r = 251;
+  int i, k, x, y, th;
+  int success = 1;
+
+  for(i=0; i<n; i++){
+    r = r * 1103515245u + 12345u;
+    vals.push_back((r >> 8) % (n/2 + 1));
+    ref.insert(vals[i]);
+    mref.insert(vals[i]);
+  }
+
+  for(th=1; th<=4; th+=3){
+    std::vector<int> a(vals), b(vals);
+    bst<int> *t = bst<int>::from_unsorted(std::move(a), th);
+    bst<int, std::less<int>, true> *m =
+      bst<int, std::less<int>, true>::from_unsorted(std::move(b), th);
+
+    if(!a.empty() || t->size() != ref.size() || m->size() != n ||
+        t->height() != balanced_height(ref.size()))
+      success = 0;
+    for(i=1; i<=ref.size(); i++){
+      if(!t->get_ith(i, x) || !ref.get_ith(i, y) || x != y)
+        success = 0;
+    }
+    for(i=1; i<=n; i++){
+      if(!m->get_ith(i, x) || !mref.get_ith(i, y) || x != y)
+        success = 0;
+    }
+    for(i=-1; i<=n/2+1; i++){
+      if(t->num_leq(i) != ref.num_leq(i) || m->num_leq(i) != mref.num_leq(i))
+        success = 0;
+    }
+
+    k = t->size();
+    for(i=0; i<=n/2; i+=2){
+      if(t->remove(i))
+        t->insert(n + i);
+    }
+    if(t->size() != k || t->memory_usage().nodes != (size_t)k)
+      success = 0;
+    delete t;
+    delete m;
+  }
+  return success;
+}
+
+
+
+
+int main(int argc, char *argv[]) {
+  int n = __N;
+  int n2 = __N2;
+  int ntrials = __NTRIALS;
+
+  if(argc > 1)
+    n = atoi(argv[1]);
+  if(argc > 2)
+    ntrials = atoi(argv[2]);
+
+  set_ntrials(ntrials);
+
+
+
+  START("[from_unsorted]: parallel sort, dedup and bulk build");
+
+  TEST_RET_MESSAGE(baseline(), "COMPILATION", 1, 1.5);
+  TEST_RET_MESSAGE(test(n), "CORRECTNESS-ONLY-TEST", 1, 2.25);
+  TIME_RATIO(test(n), test(n2), "", 1, 2.5, 3.75);
+
+
+  report();
+
+  END;
+}
@@ -13,7 +13,7 @@
 // char *Desc= "num_leq test 2";
 
 int test(int h, int n) {
-  bst<int> *t = build_balanced(h);
+  test_tree *t = build_balanced(h);
   int success = 1;
   int i;
   int x;
@@ -25,7 +25,7 @@
  *         has not been implemented.
  */
 int test(int h, int n) {
-  bst<int> *t = build_balanced(h);
+  test_tree *t = build_balanced(h);
   int x;
   int success = 1;
   int target;
@@ -0,0 +1,670 @@
+#ifndef _BST_INT_H
+#define _BST_INT_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * class bst_int_set<T>
+ *
+ * General description:  a SET of integers (T any integral type) with
+ *    the query interface of bst<T> (insert, remove, contains, size,
+ *    min, max, to_vector, get_ith, num_leq, num_geq, num_range,
+ *    from_sorted_vec), kept in a B+-tree instead of a binary tree.
+ *
+ *    - Leaves hold up to LEAF sorted keys in one 64-byte, 64-byte
+ *      aligned block (16 ints, 8 long longs) and nothing else:  the
+ *      number of keys in a leaf is its count in the parent.
+ *    - Inner nodes hold up to FAN children with, for each, the
+ *      smallest key that may be in it (sep) and the number of keys
+ *      below it (count), which is what the rank queries use.
+ *
+ *    Searching a node compares x with every slot and adds up the
+ *    results instead of stopping at the first larger key:  a fixed
+ *    loop with no data-dependent branch, which the compiler turns
+ *    into a few vector compares.  A descent touches about
+ *    log_FAN(n) inner nodes plus one cache line, against log2(n)
+ *    scattered nodes for bst<int>.
+ *
+ *    Nodes other than the root keep at least a quarter of their
+ *    capacity (an underfull node borrows from or merges with a
+ *    neighbour), so every operation is O(log n), with the per-node
+ *    work bounded by FAN.  The one exception:  an insert past
+ *    either end of the set splits a full node on that edge
+ *    unevenly, keeping its old entries together in one full node,
+ *    so sorted input fills its nodes completely instead of by
+ *    half.  Only the first and last node of a level can then be
+ *    below a quarter.
+ *
+ *    This is an opt-in alternative, not a specialization of bst<T>:
+ *    height() is the height of the B+-tree and the balancing
+ *    policies, multisets and traversal/printing functions of bst do
+ *    not apply.
+ */
+template <typename T>
+class bst_int_set {
+
+  static_assert(std::is_integral<T>::value,
+      "bst_int_set:  T must be an integral type");
+
+  public:
+    static const int LEAF = 64 / sizeof(T) < 4 ? 4 : 64 / sizeof(T);
+    static const int FAN = 16;
+
+  private:
+    struct alignas(64) leaf_node {
+      T keys[LEAF];
+    };
+
+    struct inner_node {
+      T    sep[FAN];     // sep[i]:  lower bound of child i (sep[0] unused)
+      int  count[FAN];   // count[i]:  keys below child i
+      void *child[FAN];
+      int  n;            // number of children
+    };
+
+    static const int MIN_LEAF = LEAF / 4 < 1 ? 1 : LEAF / 4;
+    static const int MIN_FAN = FAN / 4 < 2 ? 2 : FAN / 4;
+
+    void *root;      // a leaf_node if levels == 1;  nullptr if empty
+    int  levels;     // 0 if empty
+    int  n_keys;
+
+  public:
+    // constructor:  initializes an empty set
+    bst_int_set() : root(nullptr), levels(0), n_keys(0) { }
+
+    bst_int_set(const bst_int_set & other)
+      : root(nullptr), levels(0), n_keys(0)
+    {
+      std::vector<T> a;
+
+      other._collect(other.root, other.levels, other.n_keys, a);
+      _build(a, (int)a.size());
+    }
+
+    // move constructor:  O(1) -- steals other's nodes, leaving it
+    //   empty.
+    bst_int_set(bst_int_set && other)
+      : root(nullptr), levels(0), n_keys(0)
+    {
+      swap(other);
+    }
+
+    // copy and move assignment (copy-and-swap)
+    bst_int_set & operator=(bst_int_set other){
+      swap(other);
+      return *this;
+    }
+
+    void swap(bst_int_set & other){
+      std::swap(root, other.root);
+      std::swap(levels, other.levels);
+      std::swap(n_keys, other.n_keys);
+    }
+
+    ~bst_int_set() {
+      _free(root, levels);
+    }
+
+  private:
+    // new nodes are zeroed:  the in-node searches read every slot,
+    //   including the ones past the node's size.
+    static leaf_node * _new_leaf(){
+      void *p;
+
+      if(posix_memalign(&p, 64, sizeof(leaf_node)) != 0)
+        throw std::bad_alloc();
+      memset(p, 0, sizeof(leaf_node));
+      return (leaf_node *)p;
+    }
+
+    static inner_node * _new_inner(){
+      return new inner_node();
+    }
+
+    static void _free(void *p, int lv){
+      int i;
+      inner_node *q;
+
+      if(p == nullptr)
+        return;
+      if(lv == 1){
+        free(p);
+        return;
+      }
+      q = (inner_node *)p;
+      for(i=0; i<q->n; i++)
+        _free(q->child[i], lv-1);
+      delete q;
+    }
+
+    // number of keys below q
+    static int _weight(const inner_node *q){
+      int i, s = 0;
+
+      for(i=0; i<q->n; i++)
+        s += q->count[i];
+      return s;
+    }
+
+    /*
+     * Branchless in-node searches:  every slot is compared, the
+     *   slots past the node's size are masked off.
+     */
+
+    // keys of a leaf (n of them) that are < x
+    static int _rank_lt(const leaf_node *l, int n, T x){
+      int i, r = 0;
+
+      for(i=0; i<LEAF; i++)
+        r += (i < n) & (l->keys[i] < x);
+      return r;
+    }
+
+    // keys of a leaf (n of them) that are <= x
+    static int _rank_leq(const leaf_node *l, int n, T x){
+      int i, r = 0;
+
+      for(i=0; i<LEAF; i++)
+        r += (i < n) & (l->keys[i] <= x);
+      return r;
+    }
+
+    // the child of q that may hold x
+    static int _route(const inner_node *q, T x){
+      int i, r = 0;
+
+      for(i=1; i<FAN; i++)
+        r += (i < q->n) & (q->sep[i] <= x);
+      return r;
+    }
+
+    // the child of q holding the first key >= x (keys < x:  children
+    //   before it, plus its own keys < x)
+    static int _route_lt(const inner_node *q, T x){
+      int i, r = 0;
+
+      for(i=1; i<FAN; i++)
+        r += (i < q->n) & (q->sep[i] < x);
+      return r;
+    }
+
+    // number of keys <= x (or < x if strict)
+    int _rank(T x, bool strict) const {
+      void *p = root;
+      int lv, c, i, n = n_keys, r = 0;
+      const inner_node *q;
+
+      if(p == nullptr)
+        return 0;
+      for(lv=levels; lv>1; lv--){
+        q = (const inner_node *)p;
+        c = strict ? _route_lt(q, x) : _route(q, x);
+        for(i=0; i<c; i++)
+          r += q->count[i];
+        n = q->count[c];
+        p = q->child[c];
+      }
+      return r + (strict ? _rank_lt((const leaf_node *)p, n, x)
+                         : _rank_leq((const leaf_node *)p, n, x));
+    }
+
+    // puts (s, ch, cnt) in slot k of q, which has room
+    static void _put_child(inner_node *q, int k, T s, void *ch, int cnt){
+      int i;
+
+      for(i=q->n; i>k; i--){
+        q->sep[i] = q->sep[i-1];
+        q->child[i] = q->child[i-1];
+        q->count[i] = q->count[i-1];
+      }
+      q->sep[k] = s;
+      q->child[k] = ch;
+      q->count[k] = cnt;
+      q->n++;
+    }
+
+    static void _drop_child(inner_node *q, int k){
+      int i;
+
+      for(i=k; i<q->n-1; i++){
+        q->sep[i] = q->sep[i+1];
+        q->child[i] = q->child[i+1];
+        q->count[i] = q->count[i+1];
+      }
+      q->n--;
+    }
+
+    /*
+     * _insert:  inserts x below p (level lv, n keys);  returns false
+     *   if x was already there.  If p had to split, *right is the new
+     *   right sibling, *rmin its lower bound and *rcount its number
+     *   of keys;  else *right is nullptr.  first / last:  p is the
+     *   first / last node of its level.
+     */
+    bool _insert(void *p, int lv, int n, T x, void **right, T *rmin,
+        int *rcount, bool first, bool last){
+      int pos, h, c, i;
+
+      *right = nullptr;
+      if(lv == 1){
+        leaf_node *l = (leaf_node *)p;
+        leaf_node *r;
+
+        pos = _rank_lt(l, n, x);
+        if(pos < n && l->keys[pos] == x)
+          return false;
+        if(n == LEAF){
+          // split in half, or keep the full leaf whole if x is a new
+          //   maximum / minimum of the set
+          h = last && pos == n ? LEAF : first && pos == 0 ? 0 : LEAF / 2;
+          r = _new_leaf();
+          memcpy(r->keys, l->keys + h, (LEAF - h) * sizeof(T));
+          *right = r;
+          if(pos > h || pos == LEAF){
+            l = r;
+            pos -= h;
+            n = LEAF - h;
+          }
+          else
+            n = h;
+        }
+        memmove(l->keys + pos + 1, l->keys + pos, (n - pos) * sizeof(T));
+        l->keys[pos] = x;
+        if(*right != nullptr){
+          *rmin = ((leaf_node *)*right)->keys[0];
+          *rcount = LEAF - h + (l == *right);
+        }
+        return true;
+      }
+
+      inner_node *q = (inner_node *)p;
+      inner_node *r;
+      void *sub;
+      T smin;
+
+      c = _route(q, x);
+      if(!_insert(q->child[c], lv-1, q->count[c], x, &sub, &smin, &i,
+            first && c == 0, last && c == q->n - 1))
+        return false;
+      if(sub == nullptr){
+        q->count[c]++;
+        return true;
+      }
+      // child c split in two:  its new right half goes in slot c+1
+      q->count[c] += 1 - i;
+      if(q->n == FAN){
+        // as for a leaf:  on an edge of the set the old children stay
+        //   in one node
+        h = last && c == FAN - 1 ? FAN : first && c == 0 ? 1 : FAN / 2;
+        r = _new_inner();
+        r->n = FAN - h;
+        memcpy(r->sep, q->sep + h, r->n * sizeof(T));
+        memcpy(r->count, q->count + h, r->n * sizeof(int));
+        memcpy(r->child, q->child + h, r->n * sizeof(void *));
+        q->n = h;
+        *right = r;
+        if(c + 1 > h || c + 1 == FAN)
+          _put_child(r, c + 1 - h, smin, sub, i);
+        else
+          _put_child(q, c + 1, smin, sub, i);
+        *rmin = r->sep[0];
+        *rcount = _weight(r);
+      }
+      else
+        _put_child(q, c + 1, smin, sub, i);
+      return true;
+    }
+
+    /*
+     * _remove:  removes x from below p (level lv, n keys);  returns
+     *   false if x was not there.  Children of p left underfull are
+     *   fixed by _rebalance.
+     */
+    bool _remove(void *p, int lv, int n, T x){
+      int pos, c;
+
+      if(lv == 1){
+        leaf_node *l = (leaf_node *)p;
+
+        pos = _rank_lt(l, n, x);
+        if(pos >= n || l->keys[pos] != x)
+          return false;
+        memmove(l->keys + pos, l->keys + pos + 1, (n - pos - 1) * sizeof(T));
+        return true;
+      }
+
+      inner_node *q = (inner_node *)p;
+
+      c = _route(q, x);
+      if(!_remove(q->child[c], lv-1, q->count[c], x))
+        return false;
+      q->count[c]--;
+      if(_entries(q->child[c], lv-1, q->count[c]) <
+          (lv == 2 ? MIN_LEAF : MIN_FAN) && q->n > 1)
+        _rebalance(q, lv, c);
+      return true;
+    }
+
+    // keys of a leaf / children of an inner node
+    static int _entries(void *p, int lv, int n){
+      return lv == 1 ? n : ((inner_node *)p)->n;
+    }
+
+    /*
+     * _rebalance:  child c of q (at level lv) is underfull;  it is
+     *   merged with a neighbour if the two fit in one node, else the
+     *   two share their entries evenly.
+     */
+    void _rebalance(inner_node *q, int lv, int c){
+      int a = c + 1 < q->n ? c : c - 1;   // merge/share children a, a+1
+      int na = q->count[a], nb = q->count[a+1];
+      int k, total;
+
+      if(lv == 2){
+        leaf_node *L = (leaf_node *)q->child[a];
+        leaf_node *R = (leaf_node *)q->child[a+1];
+        T buf[2 * LEAF];
+
+        total = na + nb;
+        memcpy(buf, L->keys, na * sizeof(T));
+        memcpy(buf + na, R->keys, nb * sizeof(T));
+        if(total <= LEAF){
+          memcpy(L->keys, buf, total * sizeof(T));
+          free(R);
+          q->count[a] = total;
+          _drop_child(q, a+1);
+          return;
+        }
+        k = total / 2;
+        memcpy(L->keys, buf, k * sizeof(T));
+        memcpy(R->keys, buf + k, (total - k) * sizeof(T));
+        q->count[a] = k;
+        q->count[a+1] = total - k;
+        q->sep[a+1] = R->keys[0];
+        return;
+      }
+
+      inner_node *L = (inner_node *)q->child[a];
+      inner_node *R = (inner_node *)q->child[a+1];
+      T    sep[2 * FAN];
+      int  count[2 * FAN];
+      void *child[2 * FAN];
+      int  i;
+
+      total = L->n + R->n;
+      for(i=0; i<L->n; i++){
+        sep[i] = L->sep[i];
+        count[i] = L->count[i];
+        child[i] = L->child[i];
+      }
+      for(i=0; i<R->n; i++){
+        sep[L->n + i] = i == 0 ? q->sep[a+1] : R->sep[i];
+        count[L->n + i] = R->count[i];
+        child[L->n + i] = R->child[i];
+      }
+      k = total <= FAN ? total : total / 2;
+      L->n = k;
+      R->n = total - k;
+      for(i=0; i<k; i++){
+        L->sep[i] = sep[i];
+        L->count[i] = count[i];
+        L->child[i] = child[i];
+      }
+      for(i=0; i<total-k; i++){
+        R->sep[i] = sep[k + i];
+        R->count[i] = count[k + i];
+        R->child[i] = child[k + i];
+      }
+      q->count[a] = _weight(L);
+      if(R->n == 0){
+        delete R;
+        _drop_child(q, a+1);
+        return;
+      }
+      q->count[a+1] = _weight(R);
+      q->sep[a+1] = R->sep[0];
+    }
+
+    void _collect(void *p, int lv, int n, std::vector<T> & out) const {
+      const inner_node *q = (const inner_node *)p;
+      int i;
+
+      if(p == nullptr)
+        return;
+      if(lv == 1){
+        out.insert(out.end(), ((leaf_node *)p)->keys,
+            ((leaf_node *)p)->keys + n);
+        return;
+      }
+      for(i=0; i<q->n; i++)
+        _collect(q->child[i], lv-1, q->count[i], out);
+    }
+
+    /*
+     * _build:  replaces the (empty) tree by a[0..n-1] (sorted,
+     *   distinct) level by level:  full leaves, then full inner
+     *   nodes, except that the entries of each level are spread
+     *   evenly so the last node is not left underfull.
+     */
+    void _build(const std::vector<T> & a, int n){
+      std::vector<void *> nodes, up;
+      std::vector<int> counts, up_counts;
+      std::vector<T> mins, up_mins;
+      int m, i, j, k, from, len;
+
+      if(n <= 0)
+        return;
+      m = (n + LEAF - 1) / LEAF;
+      for(i=0, from=0; i<m; i++, from+=len){
+        len = n / m + (i < n % m);
+        leaf_node *l = _new_leaf();
+        memcpy(l->keys, &a[from], len * sizeof(T));
+        nodes.push_back(l);
+        counts.push_back(len);
+        mins.push_back(a[from]);
+      }
+      levels = 1;
+      while(nodes.size() > 1){
+        m = ((int)nodes.size() + FAN - 1) / FAN;
+        up.clear();
+        up_counts.clear();
+        up_mins.clear();
+        for(i=0, from=0; i<m; i++, from+=len){
+          len = (int)nodes.size() / m + (i < (int)nodes.size() % m);
+          inner_node *q = _new_inner();
+          q->n = len;
+          k = 0;
+          for(j=0; j<len; j++){
+            q->sep[j] = mins[from + j];
+            q->count[j] = counts[from + j];
+            q->child[j] = nodes[from + j];
+            k += counts[from + j];
+          }
+          up.push_back(q);
+          up_counts.push_back(k);
+          up_mins.push_back(mins[from]);
+        }
+        nodes.swap(up);
+        counts.swap(up_counts);
+        mins.swap(up_mins);
+        levels++;
+      }
+      root = nodes[0];
+      n_keys = n;
+    }
+
+  public:
+    /**
+     * function:  insert
+     * desc:      inserts x unless already present;  returns true if
+     *            x was inserted.  O(FAN log n)
+     */
+    bool insert(const T & x){
+      void *right;
+      T rmin;
+      int rcount;
+      inner_node *q;
+
+      if(root == nullptr){
+        root = _new_leaf();
+        levels = 1;
+      }
+      if(!_insert(root, levels, n_keys, x, &right, &rmin, &rcount,
+            true, true))
+        return false;
+      if(right != nullptr){
+        // root split:  new root above the two halves
+        q = _new_inner();
+        q->n = 2;
+        q->child[0] = root;
+        q->child[1] = right;
+        q->sep[1] = rmin;
+        q->count[1] = rcount;
+        q->count[0] = n_keys + 1 - rcount;
+        root = q;
+        levels++;
+      }
+      n_keys++;
+      return true;
+    }
+
+    /**
+     * function:  remove
+     * desc:      removes x if present;  returns true if x was
+     *            removed.  O(FAN log n)
+     */
+    bool remove(const T & x){
+      inner_node *q;
+
+      if(root == nullptr || !_remove(root, levels, n_keys, x))
+        return false;
+      n_keys--;
+      if(n_keys == 0){
+        _free(root, levels);
+        root = nullptr;
+        levels = 0;
+      }
+      while(levels > 1 && ((inner_node *)root)->n == 1){
+        q = (inner_node *)root;
+        root = q->child[0];
+        delete q;
+        levels--;
+      }
+      return true;
+    }
+
+    bool contains(const T & x) const {
+      void *p = root;
+      int lv, c, n = n_keys, pos;
+      const inner_node *q;
+
+      if(p == nullptr)
+        return false;
+      for(lv=levels; lv>1; lv--){
+        q = (const inner_node *)p;
+        c = _route(q, x);
+        n = q->count[c];
+        p = q->child[c];
+      }
+      pos = _rank_lt((const leaf_node *)p, n, x);
+      return pos < n && ((const leaf_node *)p)->keys[pos] == x;
+    }
+
+    int size() const {
+      return n_keys;
+    }
+
+    // height of the B+-tree (edges from the root to a leaf);  -1 if
+    //   empty.
+    int height() const {
+      return levels - 1;
+    }
+
+    bool min(T & answer) const {
+      return get_ith(1, answer);
+    }
+
+    T max() const {
+      T answer = T();
+
+      get_ith(n_keys, answer);
+      return answer;
+    }
+
+    // the elements in sorted order (caller deletes the vector)
+    std::vector<T> * to_vector() const {
+      std::vector<T> *v = new std::vector<T>();
+
+      v->reserve(n_keys);
+      _collect(root, levels, n_keys, *v);
+      return v;
+    }
+
+    /*
+     * Function:  get_ith
+     * Description:  passes back the ith smallest element (1..size())
+     *    via x;  returns false if i is out of range.
+     *
+     * Runtime:  O(FAN log n)
+     */
+    bool get_ith(int i, T & x) const {
+      void *p = root;
+      int lv, c;
+      const inner_node *q;
+
+      if(i < 1 || i > n_keys)
+        return false;
+      for(lv=levels; lv>1; lv--){
+        q = (const inner_node *)p;
+        for(c=0; i > q->count[c]; c++)
+          i -= q->count[c];
+        p = q->child[c];
+      }
+      x = ((const leaf_node *)p)->keys[i-1];
+      return true;
+    }
+
+    // number of elements <= x
+    int num_leq(const T & x) const {
+      return _rank(x, false);
+    }
+
+    // number of elements >= x
+    int num_geq(const T & x) const {
+      return n_keys - _rank(x, true);
+    }
+
+    // number of elements in [min, max]
+    int num_range(const T & min, const T & max) const {
+      if(max < min)
+        return 0;
+      return _rank(max, false) - _rank(min, true);
+    }
+
+    /**
+     * function:  from_sorted_vec
+     * desc:      builds a set from a[0..n-1], which must be sorted
+     *            and distinct.  O(n)
+     */
+    static bst_int_set * from_sorted_vec(const std::vector<T> & a, int n){
+      bst_int_set *t = new bst_int_set();
+
+      t->_build(a, n);
+      return t;
+    }
+
+
+}; // end class bst_int_set
+
+template <typename T>
+void swap(bst_int_set<T> & a, bst_int_set<T> & b){
+  a.swap(b);
+}
+
+#endif
@@ -1,9 +1,29 @@
 #ifndef LIST_H
 #define LIST_H
 
+#include <stddef.h>
 #include <algorithm>
 #include <iostream>
 
+/**
+ * struct list_memory
+ *
+ * Memory held by one List (List::memory_usage()).  Every node is a
+ * separate heap allocation, so besides sizeof(Node) (padding
+ * included) each one pays the allocator's per-chunk overhead.  That
+ * overhead is estimated for glibc malloc on a 64-bit host:  an 8-byte
+ * header, sizes rounded up to 16 bytes, 32 bytes at least.
+ */
+struct list_memory
+{
+  size_t nodes;           // nodes allocated by the list
+  size_t node_bytes;      // sizeof(Node)
+  size_t alloc_bytes;     // estimated heap bytes per node
+  size_t reserved_bytes;  // nodes * alloc_bytes + the List object
+  size_t used_bytes;      // nodes * node_bytes
+  double overhead;        // 1 - used_bytes / reserved_bytes
+};
+
 /**
  * class List<T>
  *
@@ -35,6 +55,30 @@ private:
   int _size;
   Node *front;
   Node *back;
+  size_t n_nodes;   // nodes currently allocated (see memory_usage)
+
+  // every node is allocated and freed through these two, which
+  //   keep n_nodes up to date
+  Node *_new_node(const T &d = T{}, Node *n = nullptr)
+  {
+    n_nodes++;
+    return new Node(d, n);
+  }
+
+  void _delete_node(Node *p)
+  {
+    n_nodes--;
+    delete p;
+  }
+
+  // estimated heap bytes of one allocation of n bytes (see
+  //   list_memory)
+  static size_t _chunk_bytes(size_t n)
+  {
+    size_t c = (n + sizeof(size_t) + 15) & ~(size_t)15;
+
+    return c < 32 ? 32 : c;
+  }
 
 public:
 
@@ -43,6 +87,7 @@ public:
     front = nullptr;
     back = nullptr;
     _size=0;
+    n_nodes = 0;
   }
 
   // destructor
@@ -73,7 +118,7 @@ public:
     while (p != nullptr)
     {
       pnext = p->next;
-      delete p;
+      _delete_node(p);
       p = pnext;
     }
     front = back = nullptr;
@@ -132,6 +177,24 @@ public:
     return _size;
   }
 
+  /**
+    * function: memory_usage
+    * desc:  reports the memory held by the list (see list_memory).
+    *        O(1):  computed from a count of the allocated nodes.
+    */
+  list_memory memory_usage() const
+  {
+    list_memory m;
+
+    m.nodes = n_nodes;
+    m.node_bytes = sizeof(Node);
+    m.alloc_bytes = _chunk_bytes(sizeof(Node));
+    m.reserved_bytes = m.nodes * m.alloc_bytes + sizeof(*this);
+    m.used_bytes = m.nodes * m.node_bytes;
+    m.overhead = 1.0 - (double)m.used_bytes / m.reserved_bytes;
+    return m;
+  }
+
   /**
     * function: push_front
     * desc:  adds a new element to the front of the list (calling object) containing val.
@@ -140,7 +203,7 @@ public:
   void push_front(const T &data)
   {
     _size++;
-    front = new Node(data, front);
+    front = _new_node(data, front);
 
     if (back == nullptr)
       back = front;
@@ -166,7 +229,7 @@ public:
 
     tmp = front;
     front = front->next;
-    delete tmp;
+    _delete_node(tmp);
     if (front == nullptr)
       back = nullptr;
     return true;
@@ -180,7 +243,7 @@ public:
   void push_back(const T &val)
   {
     _size++;
-    Node *tmp = new Node(val);
+    Node *tmp = _new_node(val);
     tmp->next = nullptr;
 
     if (front == nullptr)
@@ -223,7 +286,7 @@ public:
         p->next = tmp->next;
         if (tmp == back)
           back = p;
-        delete tmp;
+        _delete_node(tmp);
         return true;
       }
       p = p->next;
@@ -439,7 +502,7 @@ public:
   {
     //Empty list
     if(front==nullptr){
-      front = new Node(x,nullptr);
+      front = _new_node(x,nullptr);
       return;
     }
 
@@ -509,83 +572,36 @@ public:
      */
   void merge_with(List<T> &other)
   {
-    Node *curr = front,*tmp;
-    Node *curr_other=other.front,*tmp_other;
-    ///a is empty
-    if(front==nullptr && other.front!=nullptr){
-      front = other.front;
-      back = other.back;
-      other.front=other.back=nullptr;
-      return;
-    }
-    //b is empty
-    else if(front!=nullptr && other.front==nullptr)
-      return;
-  //single node
-  else if(front->next==nullptr){
-    if(front->data < other.front->data){
-      front->next = other.front;
-      back = other.back;
-      other.front=other.back=nullptr;
-      return;
-    }
-    else{
-      curr_other->next = curr;
-      front = curr_other;
-      other.front=other.back=nullptr;
-      return;
-    }
+    Node *a = front, *b = other.front;
+    Node **tail = &front;   // where the next merged node is linked
 
-  }
-  //both list non Empty
-  else{
-    tmp = curr->next;
-    tmp_other = curr_other->next;
-    if(front->data>other.front->data)
-      front = other.front;
-    else{
-      while(curr_other->data>tmp->data){
-        curr = tmp;
-        tmp = curr->next;
-        if(tmp->next==nullptr){
-          tmp->next = curr_other;
-          back = other.back;
-          other.front = other.back = nullptr;
-          return;
-        }
-        else{
-          curr->next = curr_other;
-          while(tmp->data>tmp_other->data){
-            curr_other = tmp_other;
-            tmp_other = tmp_other->next;
-            if(tmp_other->next==nullptr){
-              tmp_other->next = nullptr;
-              other.front = other.back = nullptr;
-              return;
-            }
-          }
-        }
-        curr_other->next = tmp;
-        curr = tmp;
-        tmp=curr->next;
-        curr_other = tmp_other;
-        tmp_other = tmp_other->next;
-      }
-      if(other.back->data > back->data){
-        back = other.back;
-        other.back = other.front = nullptr;
-        return;
+    if (this == &other)
+      return;
+    while (a != nullptr && b != nullptr)
+    {
+      // ties:  the calling list's element comes first
+      if (b->data < a->data)
+      {
+        *tail = b;
+        b = b->next;
       }
-      else{
-        other.back = other.front = nullptr;
-        return;
+      else
+      {
+        *tail = a;
+        a = a->next;
       }
-      //End of initial while loop
+      tail = &(*tail)->next;
     }
-  }
-
-
+    *tail = (a != nullptr) ? a : b;
+    if (b != nullptr)
+      back = other.back;
 
+    // the nodes (and their count) now belong to the calling list
+    _size += other._size;
+    n_nodes += other.n_nodes;
+    other._size = 0;
+    other.n_nodes = 0;
+    other.front = other.back = nullptr;
   }
 
   /**
@@ -605,7 +621,7 @@ public:
     List<T> *clone = new List<T>;
     Node* tmp,*clone_tmp;
     //Create physical nodes for new list
-    clone_tmp = new Node();
+    clone_tmp = clone->_new_node();
     //This takes care of the first node (accounts empty list)
     clone->front = clone_tmp;
     tmp = this->front;
@@ -614,7 +630,7 @@ public:
     //Traverse through list
     //Notice when tmp!=nullptr because we already did tmp = tmp->next above
     while(tmp!=nullptr){
-      clone_tmp->next = new Node();
+      clone_tmp->next = clone->_new_node();
       clone_tmp = clone_tmp->next;
       clone_tmp->data = tmp->data;
       tmp = tmp->next;
@@ -740,39 +756,38 @@ public:
 
   List<T> *filter_leq(const T &cutoff)
   {
-    //Create new list
     List<T> *leq = new List<T>;
-    Node *tmp=front,*prev,*tmp_leq;
-    //Traverse through list
-    while(tmp!=nullptr){
-      //Go on to next node
-      if(tmp->data>cutoff){
-        prev = tmp;
-        tmp = tmp->next;
-      }
-      //Update leq list
-      else{
-        if(leq->front==nullptr){
-          tmp_leq = tmp;
-          leq->front = tmp_leq;
-          front = tmp->next;
-          tmp = tmp->next;
-          return leq;
-        }
-        else{
-          tmp_leq->next = tmp;
-          prev->next = tmp->next;
-          tmp = tmp->next;
-          tmp_leq = tmp_leq->next;
-        }
+    Node *p = front;
+    Node **keep = &front;        // next link of the kept elements
+    Node **take = &leq->front;   // next link of the removed ones
+    Node *kept = nullptr;        // last kept node
 
+    while (p != nullptr)
+    {
+      if (p->data > cutoff)
+      {
+        *keep = p;
+        keep = &p->next;
+        kept = p;
       }
+      else
+      {
+        *take = p;
+        take = &p->next;
+        leq->back = p;
+        // the node (and its count) moves to leq
+        leq->_size++;
+        leq->n_nodes++;
+        _size--;
+        n_nodes--;
+      }
+      p = p->next;
     }
-    leq->back = tmp_leq;
-    prev->next = nullptr;
-    back = prev;
+    *keep = nullptr;
+    *take = nullptr;
+    back = kept;
     return leq;
-    }
+  }
 
 
 
@@ -830,6 +845,12 @@ void printList(Node* head)
      */
   void concat(List<T> &other)
   {
+    if (this == &other)
+    {
+      std::cerr << "warning:  List::concat():  calling object same as parameter";
+      std::cerr << "\n          list unchanged\n";
+      return;
+    }
     //Empty list
     if(this->front==nullptr){
       this->front = other.front;
@@ -840,14 +861,12 @@ void printList(Node* head)
       this->back->next = other.front;
       this->back = other.back;
     }
-    //Make list b empty
+    //Make list b empty;  its nodes (and their count) are ours now
+    _size += other._size;
+    n_nodes += other.n_nodes;
+    other._size = 0;
+    other.n_nodes = 0;
     other.front = other.back = nullptr;
-    if (this == &other)
-    {
-      std::cerr << "warning:  List::concat():  calling object same as parameter";
-      std::cerr << "\n          list unchanged\n";
-      return;
-    }
     std::cout << "List::concat(): no error...\n";
 
 
@@ -0,0 +1,98 @@
+// Checks that the operations which move nodes from one List to
+//   another (concat, merge_with, filter_leq) move them exactly once
+//   and keep length() and memory_usage().nodes with the nodes.
+//
+//   build and run:  g++ -std=c++11 list_check.cpp -o list_check && ./list_check
+
+#include <assert.h>
+#include <stdio.h>
+#include "List.h"
+
+// builds a list holding a[0..n-1] in order
+static List<int> *make(const int a[], int n)
+{
+  List<int> *lst = new List<int>;
+  int i;
+
+  for (i = 0; i < n; i++)
+    lst->push_back(a[i]);
+  return lst;
+}
+
+// true if lst holds exactly a[0..n-1] and every count agrees
+static bool same(List<int> &lst, const int a[], int n)
+{
+  List<int> *c;
+  int i, x;
+  bool ok;
+
+  if (lst.is_empty())
+    return n == 0 && lst.length() == 0 && lst.memory_usage().nodes == 0;
+  c = lst.clone();
+  ok = lst.length() == n && lst.memory_usage().nodes == (size_t)n;
+  for (i = 0; i < n && ok; i++)
+    ok = c->pop_front(x) && x == a[i];
+  ok = ok && c->is_empty();
+  delete c;
+  return ok;
+}
+
+int main()
+{
+  const int a1[] = {2, 9, 1}, b1[] = {5, 1, 2};
+  const int ab1[] = {2, 9, 1, 5, 1, 2};
+  const int a2[] = {2, 3, 4, 9, 10, 30}, b2[] = {5, 8, 8, 11, 20, 40};
+  const int ab2[] = {2, 3, 4, 5, 8, 8, 9, 10, 11, 20, 30, 40};
+  const int f[] = {4, 9, 2, 4, 8, 12, 7, 3};
+  const int kept[] = {9, 8, 12, 7}, removed[] = {4, 2, 4, 3};
+  const int one[] = {1};
+  List<int> *a, *b, *leq;
+
+  // concat, including onto an empty list and with itself
+  a = make(a1, 3);
+  b = make(b1, 3);
+  a->concat(*b);
+  assert(same(*a, ab1, 6) && same(*b, ab1, 0));
+  b->concat(*a);
+  assert(same(*b, ab1, 6) && same(*a, ab1, 0));
+  b->concat(*b);
+  assert(same(*b, ab1, 6));
+  delete a;
+  delete b;
+
+  // merge_with, both ways round and with an empty list
+  a = make(a2, 6);
+  b = make(b2, 6);
+  a->merge_with(*b);
+  assert(same(*a, ab2, 12) && same(*b, ab2, 0));
+  b->merge_with(*a);
+  assert(same(*b, ab2, 12) && same(*a, ab2, 0));
+  delete a;
+  delete b;
+  a = make(b2, 6);
+  b = make(a2, 6);
+  a->merge_with(*b);
+  assert(same(*a, ab2, 12) && same(*b, ab2, 0));
+  a->push_back(50);
+  assert(a->length() == 13 && a->memory_usage().nodes == 13);
+  delete a;
+  delete b;
+
+  // filter_leq:  some, none and all of the elements
+  a = make(f, 8);
+  leq = a->filter_leq(4);
+  assert(same(*a, kept, 4) && same(*leq, removed, 4));
+  delete leq;
+  leq = a->filter_leq(0);
+  assert(same(*a, kept, 4) && same(*leq, kept, 0));
+  delete leq;
+  leq = a->filter_leq(100);
+  assert(same(*a, kept, 0) && same(*leq, kept, 4));
+  a->push_back(1);
+  assert(same(*a, one, 1));
+  delete leq;
+  delete a;
+
+  printf("list_check:  all checks passed\n");
+  return 0;
+}